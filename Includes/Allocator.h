@@ -3,17 +3,70 @@
 
 #include <cstddef>  //  for using size_t...
 #include <cstdint>  // for uintptr_t...
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "AllocatorStats.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Where Init() gets the region from. Flags can be combined, pick them with
+// SetBackingMemory() before Init():
+//   MEM_HEAP        plain malloc (default)
+//   MEM_PAGES       anonymous mmap, 4K pages
+//   MEM_HUGE_PAGES  mmap with MAP_HUGETLB (2 MB pages), if none are reserved
+//                   the region is 2 MB aligned and advised for transparent huge pages
+//   MEM_PREFAULT    every page is faulted in by Init(), not on first touch while trading
+//   MEM_LOCK        mlock the region so it is never paged out
+// Anything the OS refuses falls back one step (huge -> THP -> 4K, lock is skipped);
+// GetBackingMemory() says what the region actually got.
+//
+// SetBackingFile() puts the region in a file instead (mapped shared, 4K pages, MEM_FILE
+// in GetBackingMemory()), so it outlives the process and Sync() writes it out. There is
+// no fallback for that one: if the file can't be mapped Init() leaves GetStart() null.
+enum BackingMemory {
+    MEM_HEAP = 0,
+    MEM_PAGES = 1,
+    MEM_HUGE_PAGES = 2,
+    MEM_PREFAULT = 4,
+    MEM_LOCK = 8,
+    MEM_TRANSPARENT_HUGE_PAGES = 16, //result only: MAP_HUGETLB failed, THP advice used instead
+    MEM_FILE = 32                    //result only: the region is a shared file mapping
+};
 
 class Allocator {
 protected:
-    void* m_start_ptr;      
-    size_t m_total_size;    
-    size_t m_used_memory;   
-    size_t m_num_allocations; 
+    void* m_start_ptr;
+    size_t m_total_size;
+    size_t m_used_memory;
+    size_t m_num_allocations;
+
+    unsigned m_backing_requested;
+    unsigned m_backing;      //what the current region really is
+    size_t m_mapped_size;    //0 when the region came from malloc
+
+    std::string m_backing_file; //empty = anonymous memory
+    bool m_keep_file;           //map what is in the file instead of starting empty
+
+#ifdef HFT_ALLOCATOR_STATS
+    AllocatorStats m_stats;
+    FreeBlockTracker m_free_blocks; //only for the allocators that call StatsBlock*()
+#endif
 
 public:
-    Allocator(size_t totalSize) 
-        : m_total_size(totalSize), m_used_memory(0), m_num_allocations(0), m_start_ptr(nullptr) {
+    Allocator(size_t totalSize)
+        : m_total_size(totalSize), m_used_memory(0), m_num_allocations(0), m_start_ptr(nullptr),
+          m_backing_requested(MEM_HEAP), m_backing(MEM_HEAP), m_mapped_size(0), m_keep_file(false)
+#ifdef HFT_ALLOCATOR_STATS
+          , m_stats(totalSize)
+#endif
+    {
     }
 
     virtual ~Allocator() { m_start_ptr = nullptr; }
@@ -24,8 +77,297 @@ public:
     virtual void Reset(){}
 
     void* GetStart() const { return m_start_ptr; }
-    size_t GetUsedMemory() const { return m_used_memory; }
-    size_t GetNumAllocations() const { return m_num_allocations; }
+    //virtual so thread-safe allocators can aggregate their own counters
+    virtual size_t GetUsedMemory() const { return m_used_memory; }
+    virtual size_t GetNumAllocations() const { return m_num_allocations; }
+
+    void SetBackingMemory(unsigned flags) { m_backing_requested = flags; }
+    unsigned GetBackingMemory() const { return m_backing; }
+
+    // Region in path, before Init(). keepContents maps the file as it is (it must be
+    // exactly the allocator's size); otherwise it is created or truncated and its blocks
+    // are reserved up front. MEM_PREFAULT reads it in with MAP_POPULATE, never writes it.
+    void SetBackingFile(const char* path, bool keepContents = false) {
+        m_backing_file = path ? path : "";
+        m_keep_file = keepContents;
+    }
+
+    //file backed regions: msync [offset, offset + length), the whole region by default. true once it is on disk
+    bool Sync(size_t offset = 0, size_t length = 0) {
+#ifdef __linux__
+        if (!(m_backing & MEM_FILE) || m_start_ptr == nullptr || offset >= m_mapped_size) return false;
+        const size_t PAGE = 4096;
+        size_t first = offset & ~(PAGE - 1); //msync wants a page aligned start
+        size_t end = (length == 0 || offset + length > m_mapped_size) ? m_mapped_size : offset + length;
+        return msync((char*)m_start_ptr + first, end - first, MS_SYNC) == 0;
+#else
+        return false;
+#endif
+    }
+
+    //safe from any thread while the allocator is in use, false when stats are compiled out
+    bool GetSnapshot(AllocatorSnapshot& out) const {
+#ifdef HFT_ALLOCATOR_STATS
+        m_stats.Snapshot(out);
+        return true;
+#else
+        out = AllocatorSnapshot();
+        out.totalSize = m_total_size;
+        return false;
+#endif
+    }
+
+    //peaks, failures and the size histogram start over (same thread as Allocate)
+    void ResetStats() {
+#ifdef HFT_ALLOCATOR_STATS
+        m_stats.Reset();
+        m_stats.Publish(m_used_memory, m_num_allocations);
+#endif
+    }
+
+protected:
+    // Stats hooks, called after m_used_memory/m_num_allocations are updated. They compile
+    // to nothing without HFT_ALLOCATOR_STATS.
+    void StatsAllocated(size_t requested) {
+#ifdef HFT_ALLOCATOR_STATS
+        m_stats.OnAllocate(requested, m_used_memory, m_num_allocations);
+#else
+        (void)requested;
+#endif
+    }
+
+    void StatsFreed() {
+#ifdef HFT_ALLOCATOR_STATS
+        m_stats.OnDeallocate(m_used_memory, m_num_allocations);
+#endif
+    }
+
+    void StatsFailed() {
+#ifdef HFT_ALLOCATOR_STATS
+        m_stats.OnFailure();
+#endif
+    }
+
+    void StatsFreeBlocks(size_t count, size_t largest) {
+#ifdef HFT_ALLOCATOR_STATS
+        m_stats.SetFreeBlocks(count, largest);
+#else
+        (void)count;
+        (void)largest;
+#endif
+    }
+
+    //thread-safe allocators report usage themselves (no size histogram)
+    void StatsPublish(size_t used, size_t live) {
+#ifdef HFT_ALLOCATOR_STATS
+        m_stats.Publish(used, live);
+#else
+        (void)used;
+        (void)live;
+#endif
+    }
+
+    void StatsConfigure(AllocatorStats::FreeSpace freeSpace, size_t chunkSize = 0, bool shared = false) {
+#ifdef HFT_ALLOCATOR_STATS
+        m_stats.Configure(freeSpace, chunkSize, shared);
+#else
+        (void)freeSpace;
+        (void)chunkSize;
+        (void)shared;
+#endif
+    }
+
+    void StatsChunks(size_t count) {
+#ifdef HFT_ALLOCATOR_STATS
+        m_stats.SetNumChunks(count);
+#else
+        (void)count;
+#endif
+    }
+
+    // Free block tracking (FreeBlockTracker): report blocks as they enter/leave the free
+    // lists, then StatsPublishFreeBlocks() once per operation. scan() returns the
+    // largest free block and is only called when the previous largest was taken.
+    void StatsBlockAdded(size_t size) {
+#ifdef HFT_ALLOCATOR_STATS
+        m_free_blocks.Added(size);
+#else
+        (void)size;
+#endif
+    }
+
+    void StatsBlockRemoved(size_t size) {
+#ifdef HFT_ALLOCATOR_STATS
+        m_free_blocks.Removed(size);
+#else
+        (void)size;
+#endif
+    }
+
+    void StatsBlockMerged(size_t size) {
+#ifdef HFT_ALLOCATOR_STATS
+        m_free_blocks.Merged(size);
+#else
+        (void)size;
+#endif
+    }
+
+    void StatsBlocksCleared() {
+#ifdef HFT_ALLOCATOR_STATS
+        m_free_blocks.Clear();
+#endif
+    }
+
+    template <typename Scan>
+    void StatsPublishFreeBlocks(Scan scan) {
+#ifdef HFT_ALLOCATOR_STATS
+        if (m_free_blocks.stale) {
+            m_free_blocks.largest = scan();
+            m_free_blocks.stale = false;
+        }
+        m_stats.SetFreeBlocks(m_free_blocks.count, m_free_blocks.largest);
+#else
+        (void)scan;
+#endif
+    }
+
+    // Every Init() gets its region from here and every destructor gives it back
+    // through ReleaseMemory(), so the backing is chosen in one place.
+    void* AcquireMemory(size_t size) {
+        m_backing = MEM_HEAP;
+        m_mapped_size = 0;
+        void* ptr = nullptr;
+
+        if (!m_backing_file.empty()) {
+#ifdef __linux__
+            ptr = MapFile(size);
+#endif
+            if (ptr == nullptr) return nullptr;
+        }
+
+#ifdef __linux__
+        if (ptr == nullptr && (m_backing_requested & (MEM_PAGES | MEM_HUGE_PAGES))) {
+            ptr = MapPages(size);
+        }
+#endif
+        if (ptr == nullptr) {
+            ptr = malloc(size);
+            if (ptr == nullptr) return nullptr;
+        }
+
+        //MAP_POPULATE already did it for plain 4K mappings, Prefault() writes zeros so never on a file
+        if ((m_backing_requested & MEM_PREFAULT) && !(m_backing & (MEM_PREFAULT | MEM_FILE))) {
+            Prefault(ptr, m_mapped_size ? m_mapped_size : size);
+            m_backing |= MEM_PREFAULT;
+        }
+
+#ifdef __linux__
+        if (m_backing_requested & MEM_LOCK) {
+            if (mlock(ptr, m_mapped_size ? m_mapped_size : size) == 0) {
+                m_backing |= MEM_LOCK;
+            } else {
+                std::cout << "Allocator: mlock failed (RLIMIT_MEMLOCK?), region is not locked" << std::endl;
+            }
+        }
+#endif
+        return ptr;
+    }
+
+    void ReleaseMemory() {
+        if (m_start_ptr == nullptr) return;
+#ifdef __linux__
+        if (m_mapped_size != 0) {
+            munmap(m_start_ptr, m_mapped_size); //also drops the mlock
+        } else
+#endif
+        {
+            free(m_start_ptr);
+        }
+        m_start_ptr = nullptr;
+        m_mapped_size = 0;
+    }
+
+private:
+    //one write per 4K page, the kernel maps the whole huge page on the first one
+    static void Prefault(void* ptr, size_t size) {
+        volatile char* p = (volatile char*)ptr;
+        for (size_t offset = 0; offset < size; offset += 4096) {
+            p[offset] = 0;
+        }
+    }
+
+#ifdef __linux__
+    void* MapFile(size_t size) {
+        const char* path = m_backing_file.c_str();
+        int fd = open(path, m_keep_file ? O_RDWR : (O_RDWR | O_CREAT | O_TRUNC), 0644);
+        if (fd < 0) {
+            std::cout << "Allocator: cannot open " << path << std::endl;
+            return nullptr;
+        }
+
+        bool ok;
+        if (m_keep_file) {
+            struct stat st;
+            ok = fstat(fd, &st) == 0 && (size_t)st.st_size == size;
+            if (!ok) std::cout << "Allocator: " << path << " is not " << size << " bytes" << std::endl;
+        } else {
+            //real blocks now, so running out of disk shows up here and not as a SIGBUS later
+            ok = posix_fallocate(fd, 0, (off_t)size) == 0;
+            if (!ok) std::cout << "Allocator: cannot reserve " << size << " bytes in " << path << std::endl;
+        }
+
+        int populate = (m_backing_requested & MEM_PREFAULT) ? MAP_POPULATE : 0;
+        void* ptr = ok ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | populate, fd, 0) : MAP_FAILED;
+        close(fd); //the mapping keeps the file
+        if (ptr == MAP_FAILED) return nullptr;
+
+        m_mapped_size = size;
+        m_backing = MEM_PAGES | MEM_FILE | (populate ? MEM_PREFAULT : 0);
+        return ptr;
+    }
+
+    void* MapPages(size_t size) {
+        const size_t HUGE_PAGE = 2 * 1024 * 1024;
+        int populate = (m_backing_requested & MEM_PREFAULT) ? MAP_POPULATE : 0;
+
+        if (m_backing_requested & MEM_HUGE_PAGES) {
+            size_t rounded = (size + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1);
+
+            void* ptr = mmap(nullptr, rounded, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | populate, -1, 0);
+            if (ptr != MAP_FAILED) {
+                m_mapped_size = rounded;
+                m_backing = MEM_PAGES | MEM_HUGE_PAGES | (populate ? MEM_PREFAULT : 0);
+                return ptr;
+            }
+
+            //no reserved huge pages: map 2 MB extra, trim to a 2 MB boundary and ask for THP.
+            //no MAP_POPULATE here, it would fault 4K pages before the advice is in place
+            ptr = mmap(nullptr, rounded + HUGE_PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (ptr != MAP_FAILED) {
+                uintptr_t raw = (uintptr_t)ptr;
+                uintptr_t aligned = (raw + HUGE_PAGE - 1) & ~(uintptr_t)(HUGE_PAGE - 1);
+                if (aligned > raw) munmap(ptr, aligned - raw);
+                size_t tail = (raw + rounded + HUGE_PAGE) - (aligned + rounded);
+                if (tail > 0) munmap((void*)(aligned + rounded), tail);
+
+                m_mapped_size = rounded;
+                m_backing = MEM_PAGES;
+                if (madvise((void*)aligned, rounded, MADV_HUGEPAGE) == 0) {
+                    m_backing |= MEM_TRANSPARENT_HUGE_PAGES;
+                }
+                return (void*)aligned;
+            }
+        }
+
+        void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | populate, -1, 0);
+        if (ptr == MAP_FAILED) return nullptr;
+
+        m_mapped_size = size;
+        m_backing = MEM_PAGES | (populate ? MEM_PREFAULT : 0);
+        return ptr;
+    }
+#endif
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,225 @@
+#ifndef ALLOCATOR_STATS_H
+#define ALLOCATOR_STATS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+
+// Allocator telemetry, for sizing pools from real runs. Build with -DHFT_ALLOCATOR_STATS
+// and every allocator (and TypedPool) keeps an AllocatorStats; without the flag the
+// member and every update are compiled out and GetSnapshot() returns false.
+//
+// The allocator's own thread is the only writer and every counter is an atomic written
+// with a relaxed load + store (a plain mov on x86, no locked instruction), so a
+// monitoring thread can call GetSnapshot() at any time without stopping anyone. Each
+// field is exact on its own, but fields may come from slightly different moments.
+// Allocators that several threads use at once switch the counters to fetch_add/CAS
+// (shared mode) and only update them on their slow paths, see the allocator's comment.
+
+struct AllocatorSnapshot {
+    //class 0: 0-1 byte requests, class k: (2^(k-1), 2^k], the last class takes everything bigger
+    static const int NUM_SIZE_CLASSES = 32;
+
+    bool enabled; //false when the build has no HFT_ALLOCATOR_STATS, everything else is 0
+    size_t totalSize;
+    size_t usedMemory;
+    size_t peakUsedMemory;
+    size_t numAllocations;
+    size_t peakAllocations;
+    uint64_t failedAllocations;
+    size_t numFreeBlocks;    //pools: free chunks, linear/stack: the unused tail
+    size_t largestFreeBlock; //size of the biggest free block, block headers included
+    uint64_t sizeHistogram[NUM_SIZE_CLASSES]; //successful requests by requested size
+
+    static size_t ClassLimit(int k) { return k == 0 ? 1 : (size_t)1 << k; }
+
+    void Print(const char* label) const {
+        if (!enabled) {
+            std::cout << label << ": no allocator stats (build with -DHFT_ALLOCATOR_STATS)" << std::endl;
+            return;
+        }
+        std::cout << label << ": used " << usedMemory << " / " << totalSize << " bytes (peak " << peakUsedMemory
+                  << "), allocations " << numAllocations << " (peak " << peakAllocations << "), failed " << failedAllocations
+                  << ", free blocks " << numFreeBlocks << ", largest " << largestFreeBlock << std::endl;
+
+        std::cout << "  sizes:";
+        bool any = false;
+        for (int k = 0; k < NUM_SIZE_CLASSES; ++k) {
+            if (sizeHistogram[k] == 0) continue;
+            std::cout << "  <=" << ClassLimit(k) << ": " << sizeHistogram[k];
+            any = true;
+        }
+        std::cout << (any ? "" : " none recorded") << std::endl;
+    }
+};
+
+// Free block count and largest free block for allocators that keep free lists. The
+// owner reports every block that enters or leaves its lists; when the largest one goes
+// the value is only marked stale and recomputed once, at the end of the operation.
+struct FreeBlockTracker {
+    size_t count;
+    size_t largest; //while stale: an upper bound
+    bool stale;
+
+    FreeBlockTracker() : count(0), largest(0), stale(false) {}
+
+    void Clear() {
+        count = 0;
+        largest = 0;
+        stale = false;
+    }
+
+    void Added(size_t size) {
+        count++;
+        if (size >= largest) {
+            largest = size;
+            stale = false;
+        }
+    }
+
+    void Removed(size_t size) {
+        count--;
+        if (size == largest) stale = true;
+    }
+
+    //two free blocks became one, never smaller than either
+    void Merged(size_t size) {
+        count--;
+        if (size >= largest) {
+            largest = size;
+            stale = false;
+        }
+    }
+};
+
+class AllocatorStats {
+public:
+    // How the free space is described:
+    //   FREE_TRACKED  the allocator publishes block count and largest block (free lists, buddy, TLSF)
+    //   FREE_CHUNKS   fixed size chunks, derived from the live count (pools)
+    //   FREE_TAIL     one free block at the end of the region (linear, stack)
+    enum FreeSpace { FREE_TRACKED, FREE_CHUNKS, FREE_TAIL };
+
+private:
+    std::atomic<size_t> m_used;
+    std::atomic<size_t> m_peak_used;
+    std::atomic<size_t> m_live;
+    std::atomic<size_t> m_peak_live;
+    std::atomic<uint64_t> m_failed;
+    std::atomic<size_t> m_free_blocks;
+    std::atomic<size_t> m_largest_free;
+    std::atomic<size_t> m_num_chunks;
+    std::atomic<uint64_t> m_histogram[AllocatorSnapshot::NUM_SIZE_CLASSES];
+
+    FreeSpace m_free_space;
+    size_t m_total_size;
+    size_t m_chunk_size;
+    bool m_shared;
+
+public:
+    explicit AllocatorStats(size_t totalSize)
+        : m_free_space(FREE_TRACKED), m_total_size(totalSize), m_chunk_size(0), m_shared(false) {
+        m_num_chunks.store(0, std::memory_order_relaxed);
+        Reset();
+    }
+
+    //from the allocator's constructor, before anyone can take a snapshot
+    void Configure(FreeSpace freeSpace, size_t chunkSize = 0, bool shared = false) {
+        m_free_space = freeSpace;
+        m_chunk_size = chunkSize;
+        m_shared = shared;
+        m_num_chunks.store(chunkSize ? m_total_size / chunkSize : 0, std::memory_order_relaxed);
+    }
+
+    AllocatorStats(const AllocatorStats&) = delete;
+    AllocatorStats& operator=(const AllocatorStats&) = delete;
+
+    static int SizeClass(size_t size) {
+        if (size <= 1) return 0;
+        int k = 64 - __builtin_clzll(size - 1);
+        return k < AllocatorSnapshot::NUM_SIZE_CLASSES ? k : AllocatorSnapshot::NUM_SIZE_CLASSES - 1;
+    }
+
+    //after a successful allocation, with the allocator's counters as they are now
+    void OnAllocate(size_t requested, size_t used, size_t live) {
+        Bump(m_histogram[SizeClass(requested)], 1);
+        Publish(used, live);
+    }
+
+    void OnDeallocate(size_t used, size_t live) { Publish(used, live); }
+
+    void OnFailure() { Bump(m_failed, 1); }
+
+    //current usage, raises the peaks
+    void Publish(size_t used, size_t live) {
+        m_used.store(used, std::memory_order_relaxed);
+        m_live.store(live, std::memory_order_relaxed);
+        RaiseTo(m_peak_used, used);
+        RaiseTo(m_peak_live, live);
+    }
+
+    void SetFreeBlocks(size_t count, size_t largest) {
+        m_free_blocks.store(count, std::memory_order_relaxed);
+        m_largest_free.store(largest, std::memory_order_relaxed);
+    }
+
+    //growable pools
+    void SetNumChunks(size_t count) { m_num_chunks.store(count, std::memory_order_relaxed); }
+
+    //zeroes everything, peaks and failures included. Same thread rules as the updates.
+    void Reset() {
+        m_used.store(0, std::memory_order_relaxed);
+        m_peak_used.store(0, std::memory_order_relaxed);
+        m_live.store(0, std::memory_order_relaxed);
+        m_peak_live.store(0, std::memory_order_relaxed);
+        m_failed.store(0, std::memory_order_relaxed);
+        m_free_blocks.store(0, std::memory_order_relaxed);
+        m_largest_free.store(0, std::memory_order_relaxed);
+        for (int k = 0; k < AllocatorSnapshot::NUM_SIZE_CLASSES; ++k) m_histogram[k].store(0, std::memory_order_relaxed);
+    }
+
+    //any thread
+    void Snapshot(AllocatorSnapshot& out) const {
+        out.enabled = true;
+        out.totalSize = m_total_size;
+        out.usedMemory = m_used.load(std::memory_order_relaxed);
+        out.peakUsedMemory = m_peak_used.load(std::memory_order_relaxed);
+        out.numAllocations = m_live.load(std::memory_order_relaxed);
+        out.peakAllocations = m_peak_live.load(std::memory_order_relaxed);
+        out.failedAllocations = m_failed.load(std::memory_order_relaxed);
+        for (int k = 0; k < AllocatorSnapshot::NUM_SIZE_CLASSES; ++k) {
+            out.sizeHistogram[k] = m_histogram[k].load(std::memory_order_relaxed);
+        }
+
+        if (m_free_space == FREE_CHUNKS) {
+            size_t chunks = m_num_chunks.load(std::memory_order_relaxed);
+            out.numFreeBlocks = chunks > out.numAllocations ? chunks - out.numAllocations : 0;
+            out.largestFreeBlock = out.numFreeBlocks ? m_chunk_size : 0;
+        } else if (m_free_space == FREE_TAIL) {
+            out.numFreeBlocks = out.usedMemory < m_total_size ? 1 : 0;
+            out.largestFreeBlock = m_total_size - out.usedMemory;
+        } else {
+            out.numFreeBlocks = m_free_blocks.load(std::memory_order_relaxed);
+            out.largestFreeBlock = m_largest_free.load(std::memory_order_relaxed);
+        }
+    }
+
+private:
+    void Bump(std::atomic<uint64_t>& counter, uint64_t n) {
+        if (m_shared) counter.fetch_add(n, std::memory_order_relaxed);
+        else counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    void RaiseTo(std::atomic<size_t>& peak, size_t value) {
+        size_t current = peak.load(std::memory_order_relaxed);
+        if (value <= current) return;
+        if (!m_shared) {
+            peak.store(value, std::memory_order_relaxed);
+            return;
+        }
+        while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+    }
+};
+
+#endif
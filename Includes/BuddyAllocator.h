@@ -0,0 +1,180 @@
+#ifndef BUDDY_ALLOCATOR_H
+#define BUDDY_ALLOCATOR_H
+
+#include "Allocator.h"
+#include <cstdlib>
+#include <iostream>
+
+// Buddy allocator. The region is managed as power-of-two blocks: a block of order k
+// is 2^k bytes and starts at an offset that is a multiple of 2^k, so its "buddy" (the
+// other half of the block it was split from) is at offset ^ 2^k. Allocate rounds the
+// request up to a power of two, takes the smallest free block that fits (one bit scan
+// over the non-empty orders) and splits it down; Deallocate merges with the buddy as
+// long as the buddy is free and of the same order.
+//
+// Every block start holds a tag (order + free/used bit), so checking the buddy needs no
+// side table. Only the largest power of two that fits in totalSize is managed.
+//   used: [tag][padding][AllocationHeader][payload...]
+//   free: [tag][prev][next] ...
+class BuddyAllocator : public Allocator {
+private:
+    static const int MIN_ORDER = 5; //32 bytes, room for a free block header
+    static const int MAX_ORDERS = 64;
+
+    static const size_t TAG_FREE = 0x100;
+    static const size_t TAG_USED = 0x200;
+    static const size_t ORDER_MASK = 0xFF;
+
+    struct AllocationHeader {
+        size_t tag; //same value as the block tag
+        size_t padding;
+    };
+
+    struct FreeBlock {
+        size_t tag;
+        FreeBlock* prev;
+        FreeBlock* next;
+    };
+
+    FreeBlock* m_free_lists[MAX_ORDERS];
+    uint64_t m_order_bitmap; //bit k set while m_free_lists[k] is not empty
+    int m_max_order;
+    size_t m_num_free_blocks;
+
+public:
+    BuddyAllocator(size_t totalSize) : Allocator(totalSize), m_order_bitmap(0), m_num_free_blocks(0) {
+        m_max_order = 63 - __builtin_clzll(totalSize);
+        for (int k = 0; k < MAX_ORDERS; ++k) m_free_lists[k] = nullptr;
+        StatsConfigure(AllocatorStats::FREE_TRACKED);
+    }
+
+    void Init() override {
+        ReleaseMemory();
+        m_start_ptr = AcquireMemory(m_total_size);
+
+        Reset();
+    }
+
+    ~BuddyAllocator() {
+        ReleaseMemory();
+    }
+
+    void* Allocate(size_t size, size_t alignment = 8) override {
+        //blocks are aligned to their own size, so the payload is 16 aligned for free
+        size_t needed = size + sizeof(AllocationHeader) + (alignment > 16 ? alignment - 16 : 0);
+        int order = OrderFor(needed);
+
+        uint64_t candidates = (order < MAX_ORDERS) ? (m_order_bitmap & (~0ULL << order)) : 0;
+        if (candidates == 0) {
+            std::cout << "BuddyAllocator: No block big enough found!" << std::endl;
+            StatsFailed();
+            return nullptr;
+        }
+
+        int k = __builtin_ctzll(candidates);
+        FreeBlock* block = m_free_lists[k];
+        RemoveFree(block, k);
+
+        //split down, the upper halves go back to the free lists
+        while (k > order) {
+            k--;
+            FreeBlock* upper = (FreeBlock*)((uintptr_t)block + ((size_t)1 << k));
+            PushFree(upper, k);
+        }
+
+        uintptr_t start = (uintptr_t)block;
+        size_t tag = (size_t)order | TAG_USED;
+        block->tag = tag;
+
+        uintptr_t header_end = start + sizeof(AllocationHeader);
+        size_t padding = 0;
+        size_t mask = alignment - 1;
+        if (header_end & mask) {
+            padding = alignment - (header_end & mask);
+        }
+
+        AllocationHeader* header = (AllocationHeader*)(start + padding);
+        header->tag = tag;
+        header->padding = padding;
+
+        m_used_memory += (size_t)1 << order;
+        m_num_allocations++;
+        StatsAllocated(size);
+        StatsFreeBlocks(m_num_free_blocks, GetLargestFreeBlock());
+
+        return (void*)((uintptr_t)header + sizeof(AllocationHeader));
+    }
+
+    void Deallocate(void* ptr) override {
+        AllocationHeader* header = (AllocationHeader*)((uintptr_t)ptr - sizeof(AllocationHeader));
+        uintptr_t start = (uintptr_t)header - header->padding;
+        int order = (int)(header->tag & ORDER_MASK);
+
+        m_used_memory -= (size_t)1 << order;
+        m_num_allocations--;
+
+        uintptr_t base = (uintptr_t)m_start_ptr;
+        while (order < m_max_order) {
+            uintptr_t buddy = base + ((start - base) ^ ((size_t)1 << order));
+            FreeBlock* buddyBlock = (FreeBlock*)buddy;
+
+            //a split or used buddy has a different tag at its start
+            if (buddyBlock->tag != ((size_t)order | TAG_FREE)) break;
+
+            RemoveFree(buddyBlock, order);
+            if (buddy < start) start = buddy;
+            order++;
+        }
+
+        PushFree((FreeBlock*)start, order);
+
+        StatsFreed();
+        StatsFreeBlocks(m_num_free_blocks, GetLargestFreeBlock());
+    }
+
+    void Reset() override {
+        m_used_memory = 0;
+        m_num_allocations = 0;
+        m_order_bitmap = 0;
+        m_num_free_blocks = 0;
+        for (int k = 0; k < MAX_ORDERS; ++k) m_free_lists[k] = nullptr;
+
+        PushFree((FreeBlock*)m_start_ptr, m_max_order);
+
+        StatsFreed();
+        StatsFreeBlocks(m_num_free_blocks, GetLargestFreeBlock());
+    }
+
+    size_t GetManagedSize() const { return (size_t)1 << m_max_order; }
+    size_t GetNumFreeBlocks() const { return m_num_free_blocks; }
+
+    size_t GetLargestFreeBlock() const {
+        return m_order_bitmap ? ((size_t)1 << (63 - __builtin_clzll(m_order_bitmap))) : 0;
+    }
+
+private:
+    static int OrderFor(size_t size) {
+        int order = (size <= 1) ? 0 : 64 - __builtin_clzll(size - 1);
+        return order < MIN_ORDER ? MIN_ORDER : order;
+    }
+
+    void PushFree(FreeBlock* block, int order) {
+        block->tag = (size_t)order | TAG_FREE;
+        block->prev = nullptr;
+        block->next = m_free_lists[order];
+        if (block->next) block->next->prev = block;
+        m_free_lists[order] = block;
+        m_order_bitmap |= (1ULL << order);
+        m_num_free_blocks++;
+    }
+
+    void RemoveFree(FreeBlock* block, int order) {
+        if (block->prev) block->prev->next = block->next;
+        else m_free_lists[order] = block->next;
+        if (block->next) block->next->prev = block->prev;
+        if (m_free_lists[order] == nullptr) m_order_bitmap &= ~(1ULL << order);
+        m_num_free_blocks--;
+    }
+};
+
+#endif
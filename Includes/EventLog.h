@@ -0,0 +1,200 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <string>
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+
+#include "SPSCRing.h"
+#include "PriceScale.h"
+
+// Execution event as the matcher emits it: fixed size, no strings, no formatting.
+// Which fields mean something depends on kind (see EventLog::Format).
+enum EventKind : uint8_t {
+    EVENT_TRADE,            //orderId hit otherId for qty at price
+    EVENT_BOOK,             //orderId rests at price
+    EVENT_CANCEL,
+    EVENT_REDUCE,           //modify kept the queue position, qty is the new quantity
+    EVENT_REQUEUE,          //modify pulled the order, it comes back at price
+    EVENT_REJECT_DUPLICATE,
+    EVENT_REJECT_PRICE_BAND,
+    EVENT_REJECT_ORDER_POOL,
+    EVENT_REJECT_LEVEL_POOL,
+    EVENT_REJECT_UNKNOWN_CANCEL,
+    EVENT_REJECT_UNKNOWN_MODIFY
+};
+
+struct ExecutionEvent {
+    uint8_t kind;
+    char side; //'B' or 'S', side of orderId
+    uint16_t scale; //EventLog::AddScale() slot of the emitting book's PriceScale
+    int orderId;
+    int otherId;
+    int qty;
+    Price price; //ticks, the log thread turns them into a decimal
+};
+
+// Asynchronous text log of execution events. The matching thread only copies a 24 byte
+// event into an SPSC ring; a background thread turns events into the usual
+// [TRADE]/[BOOK]/... lines and writes them in large batches, flushing when it runs out
+// of work. When the ring is full the producer either drops the event (DROP, counted in
+// GetDropped()) or waits for the writer (BLOCK, nothing lost but the matcher stalls).
+//
+// Prices stay in ticks until the log thread formats them: every book registers its
+// PriceScale with AddScale() and stamps the slot it got on its events, so books with
+// different tick sizes can share a log.
+//
+// One producer thread per log. Stop() (or the destructor) drains everything already
+// pushed before returning.
+class EventLog {
+public:
+    enum FullPolicy { DROP, BLOCK };
+
+    static const size_t RING_SIZE = 64 * 1024;
+    static const size_t WRITE_BATCH = 64 * 1024; //bytes of text per fwrite
+    static const size_t MAX_SCALES = 1024;       //one per symbol a shard can hold
+
+private:
+    typedef SPSCRing<ExecutionEvent, RING_SIZE> Ring;
+
+    Ring* ring;
+    FILE* out;
+    FullPolicy policy;
+
+    //written by the producer before the first event that uses a slot, the ring's
+    //publish makes it visible to the log thread
+    PriceScale scales[MAX_SCALES];
+    size_t numScales;
+
+    std::atomic<uint64_t> dropped; //written by the producer only
+    std::atomic<uint64_t> written; //written by the log thread only
+    std::atomic<bool> running;
+    std::thread writer;
+
+public:
+    EventLog(FILE* output = stdout, FullPolicy fullPolicy = DROP)
+        : ring(new Ring()), out(output), policy(fullPolicy), numScales(0), dropped(0), written(0), running(true) {
+        writer = std::thread(&EventLog::Run, this);
+    }
+
+    ~EventLog() {
+        Stop();
+        delete ring;
+    }
+
+    EventLog(const EventLog&) = delete;
+    EventLog& operator=(const EventLog&) = delete;
+
+    //producer side, when a book is attached. Books with the same tick size share a slot;
+    //once every slot is taken new scales get slot 0.
+    uint16_t AddScale(const PriceScale& scale) {
+        for (size_t i = 0; i < numScales; ++i) {
+            if (scales[i].tickSize == scale.tickSize) return (uint16_t)i;
+        }
+        if (numScales == MAX_SCALES) return 0;
+        scales[numScales] = scale;
+        return (uint16_t)numScales++;
+    }
+
+    //producer side, the only thing on the hot path
+    void Push(const ExecutionEvent& event) {
+        ExecutionEvent* slot;
+        while ((slot = ring->TryClaim()) == nullptr) {
+            if (policy == DROP) {
+                dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return;
+            }
+            std::this_thread::yield();
+        }
+        *slot = event;
+        ring->Publish();
+    }
+
+    //drains and joins the writer, later pushes are never written
+    void Stop() {
+        if (!running.exchange(false)) return;
+        if (writer.joinable()) writer.join();
+    }
+
+    FullPolicy GetPolicy() const { return policy; }
+    uint64_t GetDropped() const { return dropped.load(std::memory_order_relaxed); }
+    uint64_t GetWritten() const { return written.load(std::memory_order_relaxed); }
+
+    //one line of text, newline included...
+    static int Format(const ExecutionEvent& e, const PriceScale& scale, char* buf, size_t size) {
+        double price = scale.ToDouble(e.price);
+        switch (e.kind) {
+        case EVENT_TRADE:
+            if (e.side == 'B') {
+                return snprintf(buf, size, "[TRADE] MATCH! Buy Order %d bought %d units : %g from Seller %d\n", e.orderId, e.qty, price, e.otherId);
+            }
+            return snprintf(buf, size, "[TRADE] MATCH! Sell Order %d sold %d units : %g to Buyer %d\n", e.orderId, e.qty, price, e.otherId);
+        case EVENT_BOOK:
+            return snprintf(buf, size, "[BOOK] %s Order %d placed @ %g\n", e.side == 'B' ? "BUY" : "SELL", e.orderId, price);
+        case EVENT_CANCEL:
+            return snprintf(buf, size, "[CANCEL] Order %d removed\n", e.orderId);
+        case EVENT_REDUCE:
+            return snprintf(buf, size, "[MODIFY] Order %d reduced to %d\n", e.orderId, e.qty);
+        case EVENT_REQUEUE:
+            return snprintf(buf, size, "[MODIFY] Order %d requeued @ %g\n", e.orderId, price);
+        case EVENT_REJECT_DUPLICATE:
+            return snprintf(buf, size, "[REJECT] Order %d : duplicate order id\n", e.orderId);
+        case EVENT_REJECT_PRICE_BAND:
+            return snprintf(buf, size, "[REJECT] Order %d @ %g is outside the price band\n", e.orderId, price);
+        case EVENT_REJECT_ORDER_POOL:
+            return snprintf(buf, size, "[REJECT] Order %d : order pool exhausted\n", e.orderId);
+        case EVENT_REJECT_LEVEL_POOL:
+            return snprintf(buf, size, "[REJECT] Order %d : level pool exhausted\n", e.orderId);
+        case EVENT_REJECT_UNKNOWN_CANCEL:
+            return snprintf(buf, size, "[REJECT] Cancel %d : unknown order\n", e.orderId);
+        case EVENT_REJECT_UNKNOWN_MODIFY:
+            return snprintf(buf, size, "[REJECT] Modify %d : unknown order\n", e.orderId);
+        default:
+            return snprintf(buf, size, "[EVENT] unknown kind %d for order %d\n", (int)e.kind, e.orderId);
+        }
+    }
+
+private:
+    void Run() {
+        std::string text;
+        text.reserve(WRITE_BATCH + 256);
+        uint64_t count = 0;
+
+        while (true) {
+            size_t n = ring->ConsumeBatch([&](const ExecutionEvent& e) {
+                char line[256];
+                int len = Format(e, scales[e.scale], line, sizeof(line));
+                if (len > 0) text.append(line, std::min((size_t)len, sizeof(line) - 1));
+            }, 1024);
+
+            if (n != 0) {
+                count += n;
+                written.store(count, std::memory_order_relaxed);
+                if (text.size() >= WRITE_BATCH) WriteOut(text);
+                continue;
+            }
+
+            //idle: whatever is buffered goes out now
+            if (!text.empty()) {
+                WriteOut(text);
+                fflush(out);
+            }
+
+            //only leave once Stop() was called AND the ring is drained
+            if (!running.load(std::memory_order_acquire) && ring->Empty()) break;
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        fflush(out);
+    }
+
+    void WriteOut(std::string& text) {
+        fwrite(text.data(), 1, text.size(), out);
+        text.clear();
+    }
+};
+
+#endif
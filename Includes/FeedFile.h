@@ -0,0 +1,282 @@
+#ifndef FEED_FILE_H
+#define FEED_FILE_H
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "IncomingMessage.h"
+
+// Binary market feed: one FeedHeader, then numRecords fixed size IncomingMessage records
+// exactly as they sit in memory (host endianness, recordSize bytes each), so a reader can
+// use them in place. The header carries what the replay needs to build a book the
+// stream fits in.
+//
+// Versions:
+//  1  56 byte header, records right after it
+//  2  header padded to 64 bytes and its size stored in headerSize, so mapped records
+//     start on a cache line (and a 32 byte record never straddles two)
+//  3  record prices are integer ticks (IncomingMessage::price), they were doubles
+// Readers accept every version up to FEED_VERSION, writers always write the latest.
+// Versions before 3 can't be used in place: they are converted into a copy on load.
+
+const char FEED_MAGIC[4] = { 'H', 'F', 'T', 'F' };
+const uint32_t FEED_VERSION = 3;
+const size_t FEED_V1_HEADER_SIZE = 56;
+
+struct FeedHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t numLevels; //price band of the book, in ticks
+    uint32_t maxLive;   //most orders that can rest at once
+    uint32_t headerSize; //offset of the first record (0 in version 1)
+    uint64_t numRecords;
+    uint64_t seed;      //generator seed, 0 if not generated
+    double midPrice;
+    double tickSize;
+    uint8_t reserved[8];
+};
+
+static_assert(sizeof(FeedHeader) == 64, "feed header must stay one cache line");
+
+//record layout of versions 1 and 2, same size as IncomingMessage
+struct FeedRecordV2 {
+    char symbol[4];
+    int orderId;
+    char side;
+    char type;
+    double price;
+    int qty;
+};
+
+static_assert(sizeof(FeedRecordV2) == sizeof(IncomingMessage), "old records must keep their size");
+
+inline void InitFeedHeader(FeedHeader& header) {
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, FEED_MAGIC, 4);
+    header.version = FEED_VERSION;
+    header.recordSize = sizeof(IncomingMessage);
+    header.headerSize = sizeof(FeedHeader);
+}
+
+inline size_t FeedDataOffset(const FeedHeader& header) {
+    return header.version == 1 ? FEED_V1_HEADER_SIZE : header.headerSize;
+}
+
+//false (and a message on cerr) if the header is not one we can use with a file of fileSize bytes
+inline bool CheckFeedHeader(const FeedHeader& header, uint64_t fileSize, const char* path) {
+    if (fileSize < FEED_V1_HEADER_SIZE || std::memcmp(header.magic, FEED_MAGIC, 4) != 0) {
+        std::cerr << "[FEED] " << path << " is not a feed file" << std::endl;
+        return false;
+    }
+    if (header.version == 0 || header.version > FEED_VERSION || header.recordSize != sizeof(IncomingMessage)) {
+        std::cerr << "[FEED] " << path << " is version " << header.version << " with " << header.recordSize
+                  << " byte records, this build reads up to version " << FEED_VERSION << " with " << sizeof(IncomingMessage) << std::endl;
+        return false;
+    }
+
+    uint64_t offset = FeedDataOffset(header);
+    if (offset < FEED_V1_HEADER_SIZE || offset > fileSize || (fileSize - offset) / header.recordSize < header.numRecords) {
+        std::cerr << "[FEED] " << path << " is truncated" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Version 1/2 records (double prices) to the current layout, in place is fine
+inline void ConvertFeedRecords(const FeedHeader& header, const void* from, IncomingMessage* to) {
+    PriceScale scale(header.tickSize);
+    for (uint64_t i = 0; i < header.numRecords; ++i) {
+        FeedRecordV2 old;
+        std::memcpy(&old, (const char*)from + i * sizeof(FeedRecordV2), sizeof(old));
+
+        IncomingMessage msg;
+        std::memcpy(msg.symbol, old.symbol, 4);
+        msg.orderId = old.orderId;
+        msg.side = old.side;
+        msg.type = old.type;
+        msg.price = scale.ToTicks(old.price);
+        msg.qty = old.qty;
+        to[i] = msg;
+    }
+}
+
+inline bool WriteFeed(const char* path, FeedHeader header, const std::vector<IncomingMessage>& records) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "[FEED] cannot create " << path << std::endl;
+        return false;
+    }
+
+    header.numRecords = records.size();
+    out.write((const char*)&header, sizeof(header));
+    if (!records.empty()) {
+        out.write((const char*)records.data(), (std::streamsize)(records.size() * sizeof(IncomingMessage)));
+    }
+    return (bool)out;
+}
+
+// Copying loader: the whole file read into a vector. Portable, and the baseline the
+// mapped reader is measured against.
+inline bool ReadFeed(const char* path, FeedHeader& header, std::vector<IncomingMessage>& records) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        std::cerr << "[FEED] cannot open " << path << std::endl;
+        return false;
+    }
+    uint64_t fileSize = (uint64_t)in.tellg();
+    in.seekg(0);
+
+    std::memset(&header, 0, sizeof(header));
+    in.read((char*)&header, (std::streamsize)std::min<uint64_t>(sizeof(header), fileSize));
+    if (!CheckFeedHeader(header, fileSize, path)) return false;
+
+    records.resize(header.numRecords);
+    in.seekg((std::streamoff)FeedDataOffset(header));
+    if (header.numRecords != 0 && !in.read((char*)records.data(), (std::streamsize)(header.numRecords * sizeof(IncomingMessage)))) {
+        std::cerr << "[FEED] " << path << " is truncated" << std::endl;
+        return false;
+    }
+    if (header.version < 3) ConvertFeedRecords(header, records.data(), records.data());
+    return true;
+}
+
+// Zero copy reader: the file is mapped read only and Records() points straight into the
+// page cache, nothing is copied or decoded (except for files older than version 3).
+// MADV_SEQUENTIAL makes the kernel read ahead aggressively (and drop pages behind us);
+// WillNeed() asks for the next window early so the consumer doesn't stall on the disk.
+// Off Linux it falls back to ReadFeed.
+class MappedFeed {
+private:
+    FeedHeader header;
+    void* map;
+    size_t mapSize;
+    const IncomingMessage* records;
+    std::vector<IncomingMessage> copy; //fallback only
+
+public:
+    MappedFeed() : map(nullptr), mapSize(0), records(nullptr) {
+        std::memset(&header, 0, sizeof(header));
+    }
+
+    ~MappedFeed() { Close(); }
+
+    MappedFeed(const MappedFeed&) = delete;
+    MappedFeed& operator=(const MappedFeed&) = delete;
+
+    bool Open(const char* path) {
+        Close();
+#ifdef __linux__
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "[FEED] cannot open " << path << std::endl;
+            return false;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            close(fd);
+            std::cerr << "[FEED] " << path << " is not a feed file" << std::endl;
+            return false;
+        }
+
+        void* ptr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd); //the mapping keeps the file alive
+        if (ptr == MAP_FAILED) {
+            std::cerr << "[FEED] cannot map " << path << std::endl;
+            return false;
+        }
+        map = ptr;
+        mapSize = (size_t)st.st_size;
+        madvise(map, mapSize, MADV_SEQUENTIAL);
+
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(&header, map, std::min(sizeof(header), mapSize));
+        if (!CheckFeedHeader(header, mapSize, path)) {
+            Close();
+            return false;
+        }
+        records = (const IncomingMessage*)((const char*)map + FeedDataOffset(header));
+
+        //old versions carry double prices: converted copy, the mapping is not needed any more
+        if (header.version < 3) {
+            copy.resize(header.numRecords);
+            ConvertFeedRecords(header, records, copy.data());
+            munmap(map, mapSize);
+            map = nullptr;
+            mapSize = 0;
+            records = copy.data();
+        }
+        return true;
+#else
+        if (!ReadFeed(path, header, copy)) return false;
+        records = copy.data();
+        return true;
+#endif
+    }
+
+    void Close() {
+#ifdef __linux__
+        if (map != nullptr) munmap(map, mapSize);
+#endif
+        map = nullptr;
+        mapSize = 0;
+        records = nullptr;
+        copy.clear();
+    }
+
+    //page level prefetch of records [from, from + count), no-op past the end
+    void WillNeed(size_t from, size_t count) const {
+#ifdef __linux__
+        if (map == nullptr || from >= header.numRecords) return;
+        if (count > header.numRecords - from) count = (size_t)header.numRecords - from;
+
+        const size_t PAGE = 4096;
+        uintptr_t begin = (uintptr_t)(records + from) & ~(uintptr_t)(PAGE - 1);
+        uintptr_t end = (uintptr_t)(records + from + count);
+        madvise((void*)begin, end - begin, MADV_WILLNEED);
+#else
+        (void)from;
+        (void)count;
+#endif
+    }
+
+    const FeedHeader& Header() const { return header; }
+    const IncomingMessage* Records() const { return records; }
+    size_t Size() const { return (size_t)header.numRecords; }
+};
+
+const size_t FEED_PREFETCH_AHEAD = 8;   //records, a few cache lines in front of the consumer
+const size_t FEED_WINDOW = 64 * 1024;   //records per MADV_WILLNEED (2 MB)
+
+// Hands every record to fn in order, prefetching the cache line FEED_PREFETCH_AHEAD
+// records ahead and asking for the pages of the next window while this one is consumed.
+template <typename Fn>
+void ForEachRecord(const MappedFeed& feed, Fn fn) {
+    const IncomingMessage* records = feed.Records();
+    const size_t n = feed.Size();
+
+    feed.WillNeed(0, FEED_WINDOW);
+    for (size_t base = 0; base < n; base += FEED_WINDOW) {
+        feed.WillNeed(base + FEED_WINDOW, FEED_WINDOW);
+
+        size_t end = std::min(n, base + FEED_WINDOW);
+        for (size_t i = base; i < end; ++i) {
+            __builtin_prefetch(&records[i + FEED_PREFETCH_AHEAD]);
+            fn(records[i]);
+        }
+    }
+}
+
+#endif
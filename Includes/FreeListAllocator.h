@@ -4,8 +4,16 @@
 #include "Allocator.h"
 #include <cstdlib>
 #include <iostream>
+#include <algorithm>
 
 class FreeListAllocator : public Allocator {
+public:
+    // FIRST_FIT: one address-ordered list, Allocate walks it until a block fits.
+    // SEGREGATED_FIT: free blocks are kept in power-of-two size bins with a bitmap of
+    // non-empty bins, so Allocate is a bit scan + taking a bin head. Blocks carry
+    // boundary tags, so Deallocate finds and merges its physical neighbours in O(1).
+    enum PlacementPolicy { FIRST_FIT, SEGREGATED_FIT };
+
 private:
     struct AllocationHeader { 
         size_t size; 
@@ -17,25 +25,57 @@ private:
         Node* next;
     };
 
+    // SEGREGATED_FIT block layout. Every block starts with a tag: its size (a multiple
+    // of 8) with the low bits used as flags. A free block also repeats its size in its
+    // last word (footer), so the block after it can find where it starts.
+    //   used: [tag][padding][AllocationHeader][payload...]
+    //   free: [tag][prevBin][nextBin] ... [footer]
+    // For used blocks AllocationHeader::size holds the same tag; with no padding the two
+    // are the same word. The region ends with a 0-size USED tag so the last block never
+    // tries to merge past the end.
+    static const size_t TAG_USED = 1;      //this block is allocated
+    static const size_t TAG_PREV_USED = 2; //the block physically before this one is allocated
+    static const size_t TAG_FLAGS = 7;
+
+    struct BinNode {
+        size_t tag;
+        BinNode* prevBin;
+        BinNode* nextBin;
+    };
+
+    static const size_t MIN_FREE_BLOCK = sizeof(BinNode) + sizeof(size_t); //+ footer
+
+    static const int NUM_BINS = 64; //bin i holds blocks with size in [2^i, 2^(i+1))
+
     Node* m_free_list_head; 
 
+    PlacementPolicy m_policy;
+    BinNode* m_bins[NUM_BINS];
+    uint64_t m_bin_bitmap; //bit i set while m_bins[i] is not empty
+
 public:
-    FreeListAllocator(size_t totalSize) : Allocator(totalSize) {
+    FreeListAllocator(size_t totalSize, PlacementPolicy policy = FIRST_FIT) : Allocator(totalSize) {
         m_free_list_head = nullptr;
+        m_policy = policy;
+        m_bin_bitmap = 0;
+        for (int i = 0; i < NUM_BINS; ++i) m_bins[i] = nullptr;
+        StatsConfigure(AllocatorStats::FREE_TRACKED);
     }
 
     void Init() override {
-        if (m_start_ptr != nullptr) free(m_start_ptr);
-        m_start_ptr = malloc(m_total_size);
+        ReleaseMemory();
+        m_start_ptr = AcquireMemory(m_total_size);
         
         Reset();
     }
 
     ~FreeListAllocator() {
-        if (m_start_ptr != nullptr) free(m_start_ptr);
+        ReleaseMemory();
     }
 
     void* Allocate(size_t size, size_t alignment = 8) override {
+        if (m_policy == SEGREGATED_FIT) return AllocateSegregated(size, alignment);
+
         // We need space for the Header + the Data
         // Total needed = sizeof(Header) + size + padding
         
@@ -67,6 +107,7 @@ public:
                 // 1. Calculate remaining space (Splitting)
                 // If the block is huge, we split it. If it's close to perfect, we take it all.
                 size_t remaining = curr_node->size - required_space;
+                StatsBlockRemoved(curr_node->size);
 
                 // Minimum size for a free node is sizeof(Node)
                 if (remaining > sizeof(Node)) {
@@ -78,6 +119,7 @@ public:
                     // Update the list links
                     if (prev_node) prev_node->next = new_free_node;
                     else m_free_list_head = new_free_node;
+                    StatsBlockAdded(remaining);
                 } else {
                     // DON'T SPLIT: Just take the whole block (waste a tiny bit)
                     if (prev_node) prev_node->next = curr_node->next;
@@ -97,6 +139,8 @@ public:
 
                 m_used_memory += required_space;
                 m_num_allocations++;
+                StatsAllocated(size);
+                PublishFreeBlocks();
 
                 return (void*)payload_addr;
             }
@@ -107,10 +151,16 @@ public:
         }
 
         std::cout << "FreeListAllocator: No block big enough found!" << std::endl;
+        StatsFailed();
         return nullptr;
     }
 
     void Deallocate(void* ptr) override {
+        if (m_policy == SEGREGATED_FIT) {
+            DeallocateSegregated(ptr);
+            return;
+        }
+
         // 1. Get the Header
         uintptr_t payload_addr = (uintptr_t)ptr;
         
@@ -152,6 +202,7 @@ public:
         else m_free_list_head = free_node;
         
         free_node->next = curr;
+        StatsBlockAdded(block_size);
 
         // 5. Coalesce (Merge neighbors)
         // Check Next
@@ -160,6 +211,7 @@ public:
             
             free_node->size += free_node->next->size;
             free_node->next = free_node->next->next;
+            StatsBlockMerged(free_node->size);
         }
 
         // Check Previous
@@ -168,15 +220,34 @@ public:
             
             prev->size += free_node->size;
             prev->next = free_node->next;
+            StatsBlockMerged(prev->size);
         }
 
         m_used_memory -= block_size;
         m_num_allocations--;
+        StatsFreed();
+        PublishFreeBlocks();
     }
 
     void Reset() override {
         m_used_memory = 0;
         m_num_allocations = 0;
+        StatsFreed();
+        StatsBlocksCleared();
+
+        if (m_policy == SEGREGATED_FIT) {
+            m_bin_bitmap = 0;
+            for (int i = 0; i < NUM_BINS; ++i) m_bins[i] = nullptr;
+
+            //block sizes stay multiples of 8, the last word is the end marker
+            size_t usable = (m_total_size & ~(size_t)7) - sizeof(size_t);
+            *(size_t*)((uintptr_t)m_start_ptr + usable) = 0 | TAG_USED;
+
+            //nothing before the first block, pretend it is in use so we never merge backwards
+            MakeFree((uintptr_t)m_start_ptr, usable, TAG_PREV_USED);
+            PublishFreeBlocks();
+            return;
+        }
 
         // Create one giant free node
         Node* first_node = (Node*)m_start_ptr;
@@ -184,6 +255,177 @@ public:
         first_node->next = nullptr;
 
         m_free_list_head = first_node;
+        StatsBlockAdded(m_total_size);
+        PublishFreeBlocks();
+    }
+
+    // Owner thread only, they walk the free lists (a monitoring thread should use
+    // GetSnapshot() instead). Sizes include the block headers.
+    size_t GetNumFreeBlocks() const {
+        size_t count = 0;
+        if (m_policy == SEGREGATED_FIT) {
+            for (int i = 0; i < NUM_BINS; ++i) {
+                for (BinNode* n = m_bins[i]; n != nullptr; n = n->nextBin) count++;
+            }
+        } else {
+            for (Node* n = m_free_list_head; n != nullptr; n = n->next) count++;
+        }
+        return count;
+    }
+
+    size_t GetLargestFreeBlock() const {
+        size_t largest = 0;
+        if (m_policy == SEGREGATED_FIT) {
+            //bins don't overlap, the largest block is in the highest non-empty one
+            if (m_bin_bitmap == 0) return 0;
+            for (BinNode* n = m_bins[FloorBin(m_bin_bitmap)]; n != nullptr; n = n->nextBin) {
+                largest = std::max(largest, n->tag & ~TAG_FLAGS);
+            }
+        } else {
+            for (Node* n = m_free_list_head; n != nullptr; n = n->next) largest = std::max(largest, n->size);
+        }
+        return largest;
+    }
+
+private:
+    void PublishFreeBlocks() {
+        StatsPublishFreeBlocks([this] { return GetLargestFreeBlock(); });
+    }
+
+    static int FloorBin(size_t size) { return 63 - __builtin_clzll(size); }
+
+    //smallest bin whose every block is >= size
+    static int CeilBin(size_t size) { return size <= 1 ? 0 : 64 - __builtin_clzll(size - 1); }
+
+    static size_t& TagAt(uintptr_t block) { return *(size_t*)block; }
+
+    void BinInsert(BinNode* node) {
+        int bin = FloorBin(node->tag & ~TAG_FLAGS);
+        node->prevBin = nullptr;
+        node->nextBin = m_bins[bin];
+        if (m_bins[bin]) m_bins[bin]->prevBin = node;
+        m_bins[bin] = node;
+        m_bin_bitmap |= (1ULL << bin);
+        StatsBlockAdded(node->tag & ~TAG_FLAGS);
+    }
+
+    void BinRemove(BinNode* node) {
+        int bin = FloorBin(node->tag & ~TAG_FLAGS);
+        if (node->prevBin) node->prevBin->nextBin = node->nextBin;
+        else m_bins[bin] = node->nextBin;
+        if (node->nextBin) node->nextBin->prevBin = node->prevBin;
+        if (m_bins[bin] == nullptr) m_bin_bitmap &= ~(1ULL << bin);
+        StatsBlockRemoved(node->tag & ~TAG_FLAGS);
+    }
+
+    //write tag + footer and put the block in its bin
+    void MakeFree(uintptr_t block, size_t size, size_t prevUsedFlag) {
+        TagAt(block) = size | prevUsedFlag;
+        *(size_t*)(block + size - sizeof(size_t)) = size;
+        BinInsert((BinNode*)block);
+    }
+
+    void* AllocateSegregated(size_t size, size_t alignment) {
+        // Worst case the payload needs (alignment - 8) bytes of padding, since blocks
+        // always start 8 aligned. Round to 8 so the next block stays aligned too.
+        size_t worst = size + sizeof(AllocationHeader) + (alignment > 8 ? alignment - 8 : 0);
+        worst = (worst + 7) & ~(size_t)7;
+        if (worst < MIN_FREE_BLOCK) worst = MIN_FREE_BLOCK;
+
+        BinNode* node = nullptr;
+        uint64_t candidates = m_bin_bitmap & (~0ULL << CeilBin(worst));
+
+        if (candidates) {
+            //any block of the first non-empty bin >= ceil class fits, take the head
+            node = m_bins[__builtin_ctzll(candidates)];
+        } else {
+            //only the bin that straddles the request is left: check its blocks one by one
+            for (BinNode* n = m_bins[FloorBin(worst)]; n != nullptr; n = n->nextBin) {
+                if ((n->tag & ~TAG_FLAGS) >= worst) { node = n; break; }
+            }
+        }
+
+        if (node == nullptr) {
+            std::cout << "FreeListAllocator: No block big enough found!" << std::endl;
+            StatsFailed();
+            return nullptr;
+        }
+
+        BinRemove(node);
+
+        uintptr_t block = (uintptr_t)node;
+        size_t block_size = node->tag & ~TAG_FLAGS;
+        size_t prev_used = node->tag & TAG_PREV_USED;
+
+        uintptr_t header_end = block + sizeof(AllocationHeader);
+        size_t padding = 0;
+        size_t mask = alignment - 1;
+        if (header_end & mask) {
+            padding = alignment - (header_end & mask);
+        }
+
+        size_t required_space = (size + padding + sizeof(AllocationHeader) + 7) & ~(size_t)7;
+        if (required_space < MIN_FREE_BLOCK) required_space = MIN_FREE_BLOCK;
+
+        size_t remaining = block_size - required_space;
+        if (remaining >= MIN_FREE_BLOCK) {
+            //SPLIT: the tail stays free, and its predecessor (us) is now in use
+            MakeFree(block + required_space, remaining, TAG_PREV_USED);
+        } else {
+            required_space = block_size;
+            TagAt(block + block_size) |= TAG_PREV_USED;
+        }
+
+        size_t tag = required_space | TAG_USED | prev_used;
+        TagAt(block) = tag;
+
+        uintptr_t header_addr = block + padding;
+        AllocationHeader* header = (AllocationHeader*)header_addr;
+        header->size = tag;
+        header->padding = padding;
+
+        m_used_memory += required_space;
+        m_num_allocations++;
+        StatsAllocated(size);
+        PublishFreeBlocks();
+
+        return (void*)(header_addr + sizeof(AllocationHeader));
+    }
+
+    void DeallocateSegregated(void* ptr) {
+        AllocationHeader* alloc_header = (AllocationHeader*)((uintptr_t)ptr - sizeof(AllocationHeader));
+        uintptr_t block = (uintptr_t)alloc_header - alloc_header->padding;
+
+        size_t tag = TagAt(block);
+        size_t block_size = tag & ~TAG_FLAGS;
+        size_t size = block_size;
+        size_t prev_used = tag & TAG_PREV_USED;
+
+        //next neighbour: merge if free, otherwise tell it we are free now
+        uintptr_t next = block + block_size;
+        size_t next_tag = TagAt(next);
+        if (!(next_tag & TAG_USED)) {
+            BinRemove((BinNode*)next);
+            size += next_tag & ~TAG_FLAGS;
+        } else {
+            TagAt(next) = next_tag & ~TAG_PREV_USED;
+        }
+
+        //previous neighbour: its footer says where it starts
+        if (!prev_used) {
+            size_t prev_size = *(size_t*)(block - sizeof(size_t));
+            block -= prev_size;
+            BinRemove((BinNode*)block);
+            size += prev_size;
+            prev_used = TagAt(block) & TAG_PREV_USED; //always set, two free blocks are never adjacent
+        }
+
+        MakeFree(block, size, prev_used);
+
+        m_used_memory -= block_size;
+        m_num_allocations--;
+        StatsFreed();
+        PublishFreeBlocks();
     }
 };
 
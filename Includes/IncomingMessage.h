@@ -0,0 +1,17 @@
+#ifndef INCOMING_MESSAGE_H
+#define INCOMING_MESSAGE_H
+
+#include "PriceScale.h"
+
+//decoded network packet, fixed size so it can live in a ring slot...
+struct IncomingMessage {
+    char symbol[4];
+    int orderId;
+    char side; // 'B' or 'S'
+    char type = 'N'; // 'N' new order, 'C' cancel, 'M' modify (price/qty are the new values)
+    Price price; // in ticks of the symbol, see PriceScale
+    int qty;
+    int clientId = 0; //fits in what used to be tail padding, still 32 bytes
+};
+
+#endif
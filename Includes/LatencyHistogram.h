@@ -0,0 +1,138 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <chrono>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Hot path latency instrumentation. Build with -DHFT_LATENCY_STATS to turn it on;
+// without it HFT_LATENCY_SCOPE expands to nothing and the histograms are not even
+// members, so the cost is exactly zero.
+//
+// Timestamps are raw TSC reads (no serialising instruction, a few ns per scope) and
+// samples go into a fixed log-linear histogram: values below 16 cycles get their own
+// bucket, above that every power of two is split in 16 buckets, so a percentile is
+// off by at most 1/16 (~6%). Recording is a bit scan and an increment, no allocation.
+
+inline uint64_t ReadTsc() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t value;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+    return value;
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Ticks per nanosecond, measured once against steady_clock over ~20 ms
+inline double TscTicksPerNano() {
+    static double ticksPerNano = 0;
+    if (ticksPerNano == 0) {
+        auto t0 = std::chrono::steady_clock::now();
+        uint64_t c0 = ReadTsc();
+        while (std::chrono::steady_clock::now() - t0 < std::chrono::milliseconds(20)) {}
+        uint64_t c1 = ReadTsc();
+        double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+        ticksPerNano = (double)(c1 - c0) / ns;
+    }
+    return ticksPerNano;
+}
+
+class LatencyHistogram {
+private:
+    static const int SUB_BITS = 4;
+    static const int SUB_COUNT = 1 << SUB_BITS;
+    static const int NUM_BUCKETS = (64 - SUB_BITS + 1) * SUB_COUNT;
+
+    uint64_t counts[NUM_BUCKETS];
+    uint64_t total;
+    uint64_t maxValue;
+
+public:
+    LatencyHistogram() { Reset(); }
+
+    void Record(uint64_t ticks) {
+        counts[BucketOf(ticks)]++;
+        total++;
+        if (ticks > maxValue) maxValue = ticks;
+    }
+
+    void Reset() {
+        memset(counts, 0, sizeof(counts));
+        total = 0;
+        maxValue = 0;
+    }
+
+    uint64_t Count() const { return total; }
+    uint64_t Max() const { return maxValue; }
+
+    //upper bound of the bucket holding the p-th percentile, in ticks
+    uint64_t Percentile(double p) const {
+        if (total == 0) return 0;
+
+        uint64_t rank = (uint64_t)(p / 100.0 * (double)total + 0.5);
+        if (rank == 0) rank = 1;
+
+        uint64_t seen = 0;
+        for (int i = 0; i < NUM_BUCKETS; ++i) {
+            seen += counts[i];
+            if (seen >= rank) {
+                uint64_t upper = UpperBound(i);
+                return upper < maxValue ? upper : maxValue;
+            }
+        }
+        return maxValue;
+    }
+
+    void Print(const char* label) const {
+        double ticksPerNano = TscTicksPerNano();
+        std::cout << label << " latency (ns, " << total << " samples): p50 " << (uint64_t)(Percentile(50) / ticksPerNano)
+                  << "  p90 " << (uint64_t)(Percentile(90) / ticksPerNano)
+                  << "  p99 " << (uint64_t)(Percentile(99) / ticksPerNano)
+                  << "  p99.9 " << (uint64_t)(Percentile(99.9) / ticksPerNano)
+                  << "  max " << (uint64_t)(Max() / ticksPerNano) << std::endl;
+    }
+
+private:
+    static int BucketOf(uint64_t value) {
+        if (value < SUB_COUNT) return (int)value;
+        int log2 = 63 - __builtin_clzll(value);
+        return (log2 - SUB_BITS + 1) * SUB_COUNT + (int)((value >> (log2 - SUB_BITS)) & (SUB_COUNT - 1));
+    }
+
+    static uint64_t UpperBound(int bucket) {
+        if (bucket < SUB_COUNT) return (uint64_t)bucket;
+        int log2 = bucket / SUB_COUNT + SUB_BITS - 1;
+        uint64_t sub = (uint64_t)(bucket % SUB_COUNT);
+        uint64_t width = 1ULL << (log2 - SUB_BITS);
+        return ((SUB_COUNT + sub) << (log2 - SUB_BITS)) + width - 1;
+    }
+};
+
+// Records the ticks between construction and the end of the enclosing scope
+class LatencyScope {
+    LatencyHistogram& histogram;
+    uint64_t start;
+public:
+    explicit LatencyScope(LatencyHistogram& h) : histogram(h), start(ReadTsc()) {}
+    ~LatencyScope() { histogram.Record(ReadTsc() - start); }
+};
+
+#define HFT_LATENCY_CONCAT2(a, b) a##b
+#define HFT_LATENCY_CONCAT(a, b) HFT_LATENCY_CONCAT2(a, b)
+
+#ifdef HFT_LATENCY_STATS
+#define HFT_LATENCY_SCOPE(histogram) LatencyScope HFT_LATENCY_CONCAT(latencyScope_, __LINE__)(histogram)
+#else
+#define HFT_LATENCY_SCOPE(histogram)
+#endif
+
+#endif
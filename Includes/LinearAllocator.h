@@ -10,21 +10,18 @@ protected:
     void* m_current_pos;
 
 public:
-    LinearAllocator(size_t totalSize) : Allocator(totalSize) {}
+    LinearAllocator(size_t totalSize) : Allocator(totalSize) {
+        StatsConfigure(AllocatorStats::FREE_TAIL);
+    }
 
     void Init() override {
-        if (m_start_ptr != nullptr) {
-            free(m_start_ptr);
-        }
-        m_start_ptr = malloc(m_total_size); // asking the OS for raw bytes...
+        ReleaseMemory();
+        m_start_ptr = AcquireMemory(m_total_size); // asking the OS for raw bytes...
         m_current_pos = m_start_ptr;       
     }
 
     ~LinearAllocator() {
-        if (m_start_ptr != nullptr) {
-            free(m_start_ptr); 
-            m_start_ptr = nullptr;
-        }
+        ReleaseMemory();
     }
 
     void* Allocate(size_t size, size_t alignment = 8) override {
@@ -41,6 +38,7 @@ public:
         
         if (m_used_memory + padding + size > m_total_size) {
             std::cout << "Error: LinearAllocator full!" << std::endl;
+            StatsFailed();
             return nullptr;
         }
         uintptr_t aligned_address = current_address + padding;
@@ -49,6 +47,7 @@ public:
         
         m_used_memory += padding + size;
         m_num_allocations++;
+        StatsAllocated(size);
 
         return (void*)aligned_address; 
     }
@@ -61,6 +60,7 @@ public:
         m_current_pos = m_start_ptr; 
         m_used_memory = 0;
         m_num_allocations = 0;
+        StatsFreed();
     }
 };
 
@@ -0,0 +1,149 @@
+#ifndef LOCK_FREE_POOL_ALLOCATOR_H
+#define LOCK_FREE_POOL_ALLOCATOR_H
+
+#include "Allocator.h"
+#include <cstdlib>
+#include <atomic>
+
+// Fixed size pool that any thread may allocate from or free into, without locks.
+// The free list is a Treiber stack, but the head is not a raw pointer: it packs the
+// 32-bit index of the top chunk (+1, so 0 means empty) with a 32-bit generation that
+// changes on every successful push/pop. A thread that read head, got preempted, and
+// comes back after the same chunk was popped and pushed again sees a different
+// generation and its CAS fails instead of corrupting the list (ABA).
+//
+// Allocate pops with one CAS, or takes a never-used chunk with a CAS on the bump index
+// while the stack is empty (the index stops at the chunk count, a full pool only loads
+// it). Deallocate pushes with one CAS, retried only if another thread won.
+//
+// With HFT_ALLOCATOR_STATS the usage comes from the fetch_add/fetch_sub results (peaks
+// raised with a CAS, only when they move) and failures are counted; no size histogram,
+// it would be one more shared cache line per call.
+class LockFreePoolAllocator : public Allocator {
+private:
+    static const uint32_t EMPTY = 0;
+
+    alignas(64) std::atomic<uint64_t> m_head; //[generation:32][index + 1:32]
+    alignas(64) std::atomic<size_t> m_bump;   //chunks >= m_bump were never handed out
+    alignas(64) std::atomic<long long> m_allocations;
+
+    size_t m_chunk_size;
+    size_t m_alignment;
+    size_t m_num_chunks;
+
+public:
+    LockFreePoolAllocator(size_t totalSize, size_t chunkSize, size_t alignment = 8)
+        : Allocator(totalSize), m_head(0), m_bump(0), m_allocations(0), m_chunk_size(chunkSize), m_alignment(alignment) {
+
+        if (m_chunk_size < sizeof(uint32_t)) {
+            m_chunk_size = sizeof(uint32_t);
+        }
+
+        size_t mask = m_alignment - 1;
+        if (m_chunk_size & mask) {
+            m_chunk_size += m_alignment - (m_chunk_size & mask);
+        }
+
+        m_num_chunks = m_total_size / m_chunk_size;
+        if (m_num_chunks > 0xFFFFFFFEu) m_num_chunks = 0xFFFFFFFEu; //indices are 32 bit
+        StatsConfigure(AllocatorStats::FREE_CHUNKS, m_chunk_size, true);
+        StatsChunks(m_num_chunks);
+    }
+
+    void Init() override {
+        ReleaseMemory();
+        m_start_ptr = AcquireMemory(m_total_size);
+
+        Reset();
+    }
+
+    ~LockFreePoolAllocator() {
+        ReleaseMemory();
+    }
+
+    //nullptr for anything a chunk can't hold
+    void* Allocate(size_t size, size_t alignment = 8) override {
+        if (size > m_chunk_size || alignment > m_alignment) {
+            StatsFailed();
+            return nullptr;
+        }
+
+        uint64_t head = m_head.load(std::memory_order_acquire);
+
+        while ((uint32_t)head != EMPTY) {
+            uint32_t top = (uint32_t)head - 1;
+
+            // The chunk may already have been popped (and written to) by another thread;
+            // then the value read here is junk but the CAS below fails on the generation.
+            uint32_t next = __atomic_load_n(NextOf(top), __ATOMIC_RELAXED);
+            uint64_t newHead = (((head >> 32) + 1) << 32) | next;
+
+            if (m_head.compare_exchange_weak(head, newHead, std::memory_order_acquire, std::memory_order_acquire)) {
+                Published(m_allocations.fetch_add(1, std::memory_order_relaxed) + 1);
+                return ChunkAt(top);
+            }
+        }
+
+        //nothing was ever freed (or everything is in use): take a fresh chunk
+        size_t fresh = m_bump.load(std::memory_order_relaxed);
+        while (fresh < m_num_chunks && !m_bump.compare_exchange_weak(fresh, fresh + 1, std::memory_order_relaxed)) {}
+        if (fresh >= m_num_chunks) {
+            StatsFailed();
+            return nullptr;
+        }
+
+        Published(m_allocations.fetch_add(1, std::memory_order_relaxed) + 1);
+        return ChunkAt((uint32_t)fresh);
+    }
+
+    void Deallocate(void* ptr) override {
+        uint32_t index = (uint32_t)(((uintptr_t)ptr - (uintptr_t)m_start_ptr) / m_chunk_size);
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        uint64_t newHead;
+
+        do {
+            __atomic_store_n(NextOf(index), (uint32_t)head, __ATOMIC_RELAXED);
+            newHead = (((head >> 32) + 1) << 32) | (uint64_t)(index + 1);
+        } while (!m_head.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed));
+
+        Published(m_allocations.fetch_sub(1, std::memory_order_relaxed) - 1);
+    }
+
+    //O(1): fresh chunks come from the bump index, not from a pre-built list. Not thread safe.
+    void Reset() override {
+        m_head.store(0);
+        m_bump.store(0);
+        m_allocations.store(0);
+        StatsPublish(0, 0);
+    }
+
+    size_t GetNumAllocations() const override {
+        long long n = m_allocations.load(std::memory_order_relaxed);
+        return n > 0 ? (size_t)n : 0;
+    }
+
+    size_t GetUsedMemory() const override {
+        return GetNumAllocations() * m_chunk_size;
+    }
+
+private:
+    void Published(long long live) {
+#ifdef HFT_ALLOCATOR_STATS
+        size_t n = live > 0 ? (size_t)live : 0;
+        StatsPublish(n * m_chunk_size, n);
+#else
+        (void)live;
+#endif
+    }
+
+    void* ChunkAt(uint32_t index) const {
+        return (void*)((uintptr_t)m_start_ptr + (uintptr_t)index * m_chunk_size);
+    }
+
+    //a free chunk stores the (index + 1) of the chunk below it in the stack
+    uint32_t* NextOf(uint32_t index) const {
+        return (uint32_t*)ChunkAt(index);
+    }
+};
+
+#endif
@@ -0,0 +1,253 @@
+#ifndef MAGAZINE_POOL_ALLOCATOR_H
+#define MAGAZINE_POOL_ALLOCATOR_H
+
+#include "Allocator.h"
+#include <cstdlib>
+#include <atomic>
+#include <mutex>
+
+// Thread-safe fixed size pool. Every thread gets a small private "magazine" of free
+// chunks, so the common Allocate/Deallocate is a plain array pop/push with no atomics
+// and no locks. When a magazine runs dry it takes a whole batch from the shared depot,
+// and when it overflows it gives a batch back, so the depot lock is taken once per
+// BATCH_SIZE operations. A chunk may be freed by a different thread than the one that
+// allocated it; it just lands in the freeing thread's magazine.
+//
+// Threads are mapped to magazine slots once (first use) and release the slot when they
+// exit. Past MAX_THREADS live threads, the extra ones share one lock-protected magazine.
+// Init()/Reset() are not thread safe.
+//
+// With HFT_ALLOCATOR_STATS nothing is added to the magazine fast path: usage and peaks
+// are sampled when a magazine goes to the depot (every BATCH_SIZE operations of a
+// thread), so a peak can be missed by up to BATCH_SIZE chunks per thread. Failures are
+// counted exactly, there is no size histogram.
+class MagazinePoolAllocator : public Allocator {
+public:
+    static const size_t MAGAZINE_SIZE = 64;
+    static const size_t BATCH_SIZE = MAGAZINE_SIZE / 2;
+    static const int MAX_THREADS = 64;
+
+private:
+    //free chunks are chained in batches of BATCH_SIZE, the depot is a stack of batches
+    struct FreeHeader {
+        FreeHeader* next;       //next chunk in this batch
+        FreeHeader* nextBatch;  //only meaningful on the first chunk of a batch
+    };
+
+    struct alignas(64) Magazine {
+        void* items[MAGAZINE_SIZE];
+        size_t count;
+        std::atomic<long long> allocations; //owner writes, monitoring reads
+    };
+
+    Magazine m_magazines[MAX_THREADS];
+    Magazine m_shared; //for threads that didn't get a slot
+    std::mutex m_shared_lock;
+
+    std::mutex m_depot_lock;
+    FreeHeader* m_depot; //full batches handed back by the magazines
+    uintptr_t m_bump; //chunks past here were never handed out
+    uintptr_t m_end;
+
+    size_t m_chunk_size;
+    size_t m_alignment;
+
+public:
+    MagazinePoolAllocator(size_t totalSize, size_t chunkSize, size_t alignment = 8)
+        : Allocator(totalSize), m_depot(nullptr), m_bump(0), m_end(0), m_chunk_size(chunkSize), m_alignment(alignment) {
+
+        if (m_chunk_size < sizeof(FreeHeader)) {
+            m_chunk_size = sizeof(FreeHeader);
+        }
+
+        size_t mask = m_alignment - 1;
+        if (m_chunk_size & mask) {
+            m_chunk_size += m_alignment - (m_chunk_size & mask);
+        }
+        StatsConfigure(AllocatorStats::FREE_CHUNKS, m_chunk_size, true);
+    }
+
+    void Init() override {
+        ReleaseMemory();
+        m_start_ptr = AcquireMemory(m_total_size);
+
+        Reset();
+    }
+
+    ~MagazinePoolAllocator() {
+        ReleaseMemory();
+    }
+
+    //nullptr for anything a chunk can't hold
+    void* Allocate(size_t size, size_t alignment = 8) override {
+        if (size > m_chunk_size || alignment > m_alignment) {
+            StatsFailed();
+            return nullptr;
+        }
+
+        int slot = ThreadSlot();
+        if (slot < 0) {
+            std::lock_guard<std::mutex> guard(m_shared_lock);
+            return AllocateFrom(m_shared);
+        }
+        return AllocateFrom(m_magazines[slot]);
+    }
+
+    void Deallocate(void* ptr) override {
+        int slot = ThreadSlot();
+        if (slot < 0) {
+            std::lock_guard<std::mutex> guard(m_shared_lock);
+            DeallocateTo(m_shared, ptr);
+            return;
+        }
+        DeallocateTo(m_magazines[slot], ptr);
+    }
+
+    // Hand the calling thread's cached chunks back to the depot, e.g. right before a
+    // short-lived thread exits, so they don't sit idle until the slot is reused.
+    void FlushThreadCache() {
+        int slot = ThreadSlot();
+        Magazine& mag = (slot < 0) ? m_shared : m_magazines[slot];
+        std::unique_lock<std::mutex> guard(m_shared_lock, std::defer_lock);
+        if (slot < 0) guard.lock();
+
+        while (mag.count > 0) Flush(mag);
+    }
+
+    // Forget every magazine and hand the whole region back to the depot.
+    // Only valid while no other thread is using the allocator.
+    void Reset() override {
+        for (int i = 0; i < MAX_THREADS; ++i) {
+            m_magazines[i].count = 0;
+            m_magazines[i].allocations.store(0, std::memory_order_relaxed);
+        }
+        m_shared.count = 0;
+        m_shared.allocations.store(0, std::memory_order_relaxed);
+
+        m_depot = nullptr;
+        m_bump = (uintptr_t)m_start_ptr;
+        m_end = m_bump + (m_total_size / m_chunk_size) * m_chunk_size;
+        StatsPublish(0, 0);
+    }
+
+    //sum of the per thread counters, safe to poll from any thread
+    size_t GetNumAllocations() const override {
+        long long total = m_shared.allocations.load(std::memory_order_relaxed);
+        for (int i = 0; i < MAX_THREADS; ++i) {
+            total += m_magazines[i].allocations.load(std::memory_order_relaxed);
+        }
+        return total > 0 ? (size_t)total : 0;
+    }
+
+    size_t GetUsedMemory() const override {
+        return GetNumAllocations() * m_chunk_size;
+    }
+
+private:
+    void* AllocateFrom(Magazine& mag) {
+        if (mag.count == 0 && !Refill(mag)) {
+            StatsFailed();
+            return nullptr;
+        }
+
+        mag.allocations.store(mag.allocations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return mag.items[--mag.count];
+    }
+
+    void DeallocateTo(Magazine& mag, void* ptr) {
+        if (mag.count == MAGAZINE_SIZE) {
+            Flush(mag);
+        }
+
+        mag.items[mag.count++] = ptr;
+        mag.allocations.store(mag.allocations.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+    }
+
+    //pull one batch from the depot, or carve one from the untouched part of the region
+    bool Refill(Magazine& mag) {
+        FreeHeader* batch = nullptr;
+        uintptr_t carved = 0;
+        size_t nCarved = 0;
+
+        {
+            std::lock_guard<std::mutex> guard(m_depot_lock);
+            if (m_depot != nullptr) {
+                batch = m_depot;
+                m_depot = batch->nextBatch;
+            } else if (m_bump < m_end) {
+                carved = m_bump;
+                nCarved = (m_end - m_bump) / m_chunk_size;
+                if (nCarved > BATCH_SIZE) nCarved = BATCH_SIZE;
+                m_bump += nCarved * m_chunk_size;
+            }
+        }
+
+        //walking the batch happens outside the lock...
+        while (batch != nullptr) {
+            mag.items[mag.count++] = batch;
+            batch = batch->next;
+        }
+        for (size_t i = 0; i < nCarved; ++i) {
+            mag.items[mag.count++] = (void*)(carved + i * m_chunk_size);
+        }
+
+        SampleUsage();
+        return mag.count != 0;
+    }
+
+    //give the top BATCH_SIZE chunks (or all of them, if fewer) back to the depot as one chain
+    void Flush(Magazine& mag) {
+        size_t n = mag.count < BATCH_SIZE ? mag.count : BATCH_SIZE;
+
+        FreeHeader* batch = nullptr;
+        for (size_t i = 0; i < n; ++i) {
+            FreeHeader* header = (FreeHeader*)mag.items[--mag.count];
+            header->next = batch;
+            batch = header;
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(m_depot_lock);
+            batch->nextBatch = m_depot;
+            m_depot = batch;
+        }
+        SampleUsage();
+    }
+
+    void SampleUsage() {
+#ifdef HFT_ALLOCATOR_STATS
+        size_t live = GetNumAllocations();
+        StatsPublish(live * m_chunk_size, live);
+#endif
+    }
+
+    // Index of the calling thread's magazine, shared by every instance. -1 once all
+    // MAX_THREADS slots are taken by live threads.
+    static int ThreadSlot() {
+        struct Holder {
+            int index;
+            Holder() : index(Claim()) {}
+            ~Holder() { if (index >= 0) SlotBits().fetch_and(~(1ULL << index)); }
+        };
+        static thread_local Holder holder;
+        return holder.index;
+    }
+
+    static std::atomic<uint64_t>& SlotBits() {
+        static std::atomic<uint64_t> bits(0);
+        return bits;
+    }
+
+    static int Claim() {
+        uint64_t used = SlotBits().load();
+        while (used != ~0ULL) {
+            int index = __builtin_ctzll(~used);
+            if (SlotBits().compare_exchange_weak(used, used | (1ULL << index))) {
+                return index;
+            }
+        }
+        return -1;
+    }
+};
+
+#endif
@@ -0,0 +1,273 @@
+#ifndef MATCHING_ENGINE_H
+#define MATCHING_ENGINE_H
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "OrderBook.h"
+#include "IncomingMessage.h"
+#include "SPSCRing.h"
+#include "EventLog.h"
+
+// Multi-symbol engine. Every symbol gets its own OrderBook (and so its own pools) and
+// symbols are spread over N matching threads. Each thread owns its books outright and
+// is fed by its own SPSC inbox, so the only thing shared on the hot path is the
+// symbol routing table, which is read-only once Start() has been called.
+//
+// Usage: AddSymbol() for every instrument, Start(), Route() from ONE gateway thread,
+// Stop() to drain the inboxes and join the workers.
+class MatchingEngine {
+public:
+    static const size_t INBOX_SIZE = 4096;
+    static const size_t MAX_SYMBOLS = 1024;
+
+    struct SymbolConfig {
+        char symbol[4];
+        double midPrice;
+        double tickSize;
+        size_t numLevels;
+        size_t maxOrders;
+    };
+
+private:
+    typedef SPSCRing<IncomingMessage, INBOX_SIZE> Inbox;
+
+    struct SymbolRoute {
+        uint32_t key; //symbol packed into 4 bytes, 0 = empty slot
+        int shard;
+        int book; //index of the book inside its shard
+    };
+
+    struct alignas(64) Shard {
+        Inbox* inbox;
+        EventLog* log; //nullptr when logging is off, one per shard since the ring is SPSC
+        std::thread worker;
+        int core;
+        std::vector<const SymbolConfig*> symbols;
+        std::atomic<uint64_t> processed; //written by the worker only
+    };
+
+    std::vector<SymbolConfig> configs;
+    std::vector<Shard*> shards;
+
+    SymbolRoute routes[MAX_SYMBOLS * 2]; //open addressing, load factor <= 0.5
+    size_t routeMask;
+
+    std::atomic<bool> running;
+    std::atomic<int> readyShards; //workers that finished building their books
+    bool logging;
+    EventLog::FullPolicy logPolicy;
+
+public:
+    MatchingEngine(int numThreads, int firstCore = 0) : routeMask(MAX_SYMBOLS * 2 - 1), running(false), readyShards(0), logging(true), logPolicy(EventLog::DROP) {
+        if (numThreads < 1) numThreads = 1;
+
+        for (int i = 0; i < numThreads; ++i) {
+            Shard* shard = new Shard();
+            shard->inbox = new Inbox();
+            shard->log = nullptr;
+            shard->core = firstCore + i;
+            shard->processed.store(0, std::memory_order_relaxed);
+            shards.push_back(shard);
+        }
+
+        std::memset(routes, 0, sizeof(routes));
+        configs.reserve(MAX_SYMBOLS);
+    }
+
+    ~MatchingEngine() {
+        Stop();
+        for (size_t i = 0; i < shards.size(); ++i) {
+            delete shards[i]->inbox;
+            delete shards[i];
+        }
+    }
+
+    //not thread safe, call before Start()...
+    bool AddSymbol(const char* symbol, double midPrice, double tickSize = 0.01,
+                   size_t numLevels = 20000, size_t maxOrders = 100000) {
+        if (running.load() || configs.size() == MAX_SYMBOLS) return false;
+
+        uint32_t key = PackSymbol(symbol);
+        if (key == 0 || FindRoute(key) != nullptr) return false;
+
+        SymbolConfig cfg;
+        std::memset(cfg.symbol, 0, sizeof(cfg.symbol)); //shorter names are zero padded
+        std::memcpy(cfg.symbol, symbol, strnlen(symbol, sizeof(cfg.symbol)));
+        cfg.midPrice = midPrice;
+        cfg.tickSize = tickSize;
+        cfg.numLevels = numLevels;
+        cfg.maxOrders = maxOrders;
+        configs.push_back(cfg);
+
+        //round robin over the shards...
+        Shard* shard = shards[(configs.size() - 1) % shards.size()];
+
+        size_t i = HashKey(key);
+        while (routes[i].key != 0) i = (i + 1) & routeMask;
+        routes[i].key = key;
+        routes[i].shard = (int)((configs.size() - 1) % shards.size());
+        routes[i].book = (int)shard->symbols.size();
+
+        shard->symbols.push_back(&configs.back());
+        return true;
+    }
+
+    //events are formatted and written by a background thread per shard, see EventLog.
+    //call before Start()...
+    void SetLogging(bool enabled, EventLog::FullPolicy policy = EventLog::DROP) {
+        logging = enabled;
+        logPolicy = policy;
+    }
+
+    //returns once every worker has its books ready
+    void Start() {
+        if (running.exchange(true)) return;
+
+        readyShards.store(0);
+        for (size_t i = 0; i < shards.size(); ++i) {
+            Shard* shard = shards[i];
+            shard->log = logging ? new EventLog(stdout, logPolicy) : nullptr;
+            shard->worker = std::thread(&MatchingEngine::RunShard, this, shard);
+        }
+
+        while (readyShards.load(std::memory_order_acquire) < (int)shards.size()) {
+            std::this_thread::yield();
+        }
+    }
+
+    //drains everything already routed, then joins the workers
+    void Stop() {
+        if (!running.exchange(false)) return;
+
+        for (size_t i = 0; i < shards.size(); ++i) {
+            if (shards[i]->worker.joinable()) shards[i]->worker.join();
+        }
+
+        //the books are gone, flush what they logged
+        for (size_t i = 0; i < shards.size(); ++i) {
+            EventLog* log = shards[i]->log;
+            if (log == nullptr) continue;
+            log->Stop();
+            if (log->GetDropped() != 0) {
+                fprintf(stderr, "[LOG] shard %d dropped %llu events, event log full\n", (int)i, (unsigned long long)log->GetDropped());
+            }
+            delete log;
+            shards[i]->log = nullptr;
+        }
+    }
+
+    // Gateway side: hand the message to the thread that owns its symbol.
+    // Spins while that inbox is full (backpressure). False for unknown symbols.
+    bool Route(const IncomingMessage& msg) {
+        const SymbolRoute* r = FindRoute(PackSymbol(msg.symbol));
+        if (r == nullptr) return false;
+
+        Inbox* inbox = shards[r->shard]->inbox;
+        IncomingMessage* slot;
+        while ((slot = inbox->TryClaim()) == nullptr) {
+            std::this_thread::yield();
+        }
+        *slot = msg;
+        inbox->Publish();
+        return true;
+    }
+
+    //for the gateway: wire prices are converted to ticks with the symbol's own scale
+    bool GetPriceScale(const char* symbol, PriceScale& scale) const {
+        const SymbolRoute* r = FindRoute(PackSymbol(symbol));
+        if (r == nullptr) return false;
+        scale = PriceScale(shards[r->shard]->symbols[r->book]->tickSize);
+        return true;
+    }
+
+    int GetNumShards() const { return (int)shards.size(); }
+
+    uint64_t GetProcessed() const {
+        uint64_t total = 0;
+        for (size_t i = 0; i < shards.size(); ++i) {
+            total += shards[i]->processed.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+private:
+    //up to 4 chars, stops at a NUL so "AB" is not read past its end
+    static uint32_t PackSymbol(const char* symbol) {
+        uint32_t key = 0;
+        std::memcpy(&key, symbol, strnlen(symbol, sizeof(key)));
+        return key;
+    }
+
+    size_t HashKey(uint32_t key) const {
+        return (size_t)((key * 2654435769u) >> 16) & routeMask;
+    }
+
+    const SymbolRoute* FindRoute(uint32_t key) const {
+        size_t i = HashKey(key);
+        while (routes[i].key != 0) {
+            if (routes[i].key == key) return &routes[i];
+            i = (i + 1) & routeMask;
+        }
+        return nullptr;
+    }
+
+    static void PinThisThread(int core) {
+#ifdef __linux__
+        unsigned int cores = std::thread::hardware_concurrency();
+        if (cores == 0) return;
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(core % cores, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+        (void)core;
+#endif
+    }
+
+    void RunShard(Shard* shard) {
+        PinThisThread(shard->core);
+
+        //books are built on the owning thread so their pools are first touched
+        //(and placed) next to the core that uses them...
+        std::vector<OrderBook*> books;
+        for (size_t i = 0; i < shard->symbols.size(); ++i) {
+            const SymbolConfig* cfg = shard->symbols[i];
+            OrderBook* book = new OrderBook(cfg->midPrice, cfg->tickSize, cfg->numLevels, cfg->maxOrders);
+            book->SetEventLog(shard->log);
+            books.push_back(book);
+        }
+        readyShards.fetch_add(1, std::memory_order_release);
+
+        uint64_t processed = 0;
+        while (true) {
+            size_t n = shard->inbox->ConsumeBatch([&](const IncomingMessage& msg) {
+                const SymbolRoute* r = FindRoute(PackSymbol(msg.symbol));
+                books[r->book]->ProcessMessage(msg);
+            });
+
+            if (n != 0) {
+                processed += n;
+                shard->processed.store(processed, std::memory_order_relaxed);
+                continue;
+            }
+
+            //only leave once Stop() was called AND the inbox is drained
+            if (!running.load(std::memory_order_acquire) && shard->inbox->Empty()) break;
+            std::this_thread::yield();
+        }
+
+        for (size_t i = 0; i < books.size(); ++i) delete books[i];
+    }
+};
+
+#endif
@@ -0,0 +1,796 @@
+#ifndef ORDER_BOOK_H
+#define ORDER_BOOK_H
+
+#include <algorithm>
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "TypedPool.h"
+#include "PriceScale.h"
+#include "LinearAllocator.h"
+#include "LatencyHistogram.h"
+#include "IncomingMessage.h"
+#include "EventLog.h"
+
+enum OrderType { BUY, SELL };
+
+// Orders are split by who touches what. Order is the hot part: everything matching,
+// cancels and level walks read, 16 bytes so 4 sit in a cache line (the old single
+// struct was 40). Links are 32-bit slot indices into the order pool instead of
+// pointers. OrderInfo is the cold part, kept in a parallel array under the same slot
+// index, and only read when an order fills, is modified or looked up.
+const uint32_t NO_ORDER = 0xFFFFFFFF;
+
+struct Order {
+    int quantity;
+    uint32_t level; //index in the book's level window, the price is baseTick + level
+    uint32_t prev;  //links inside the price level, doubly linked so a cancel can unlink in O(1)...
+    uint32_t next;
+
+    Order(int q, uint32_t l) : quantity(q), level(l), prev(NO_ORDER), next(NO_ORDER) {}
+};
+
+struct OrderInfo {
+    int id;
+    int clientId;
+    uint64_t sequence; //arrival order in this book, its clock
+    OrderType type;
+};
+
+const uint32_t NO_LEVEL = 0xFFFFFFFF;
+
+//all orders resting at the same tick, oldest first (time priority)...
+struct PriceLevel {
+    uint32_t head;
+    uint32_t tail;
+
+    PriceLevel() : head(NO_ORDER), tail(NO_ORDER) {}
+};
+
+// Open addressing (linear probing) map from order id to the slot of the resting Order.
+// The slot table is one block sized up front (the book's region), so inserts and
+// erases never touch the heap. Erase uses backward shift instead of tombstones, which
+// keeps probe chains short even when cancels dominate the flow.
+class OrderIndex {
+private:
+    struct Slot {
+        int id;
+        uint32_t order; //NO_ORDER = empty slot
+    };
+
+    Slot* slots;
+    size_t mask;
+    int shift;
+
+public:
+    //keep the load factor <= 0.5...
+    static size_t CapacityFor(size_t maxEntries) {
+        size_t capacity = 16;
+        while (capacity < maxEntries * 2) capacity <<= 1;
+        return capacity;
+    }
+
+    static size_t MemoryFor(size_t maxEntries) { return CapacityFor(maxEntries) * sizeof(Slot); }
+
+    // Slots in memory the caller owns (MemoryFor(maxEntries) bytes). clear = false keeps
+    // what is there: the table holds ids and pool slots only, so it can be mapped back.
+    OrderIndex(size_t maxEntries, void* memory, bool clear = true) {
+        size_t capacity = CapacityFor(maxEntries);
+        mask = capacity - 1;
+        shift = 32 - __builtin_ctzll(capacity);
+        slots = (Slot*)memory;
+
+        if (clear) {
+            for (size_t i = 0; i < capacity; ++i) {
+                slots[i].id = 0;
+                slots[i].order = NO_ORDER;
+            }
+        }
+    }
+
+    uint32_t Find(int id) const {
+        size_t i = Hash(id);
+        while (slots[i].order != NO_ORDER) {
+            if (slots[i].id == id) return slots[i].order;
+            i = (i + 1) & mask;
+        }
+        return NO_ORDER;
+    }
+
+    //false if the id is already there...
+    bool Insert(int id, uint32_t order) {
+        size_t i = Hash(id);
+        while (slots[i].order != NO_ORDER) {
+            if (slots[i].id == id) return false;
+            i = (i + 1) & mask;
+        }
+        slots[i].id = id;
+        slots[i].order = order;
+        return true;
+    }
+
+    //pulls in the cache line of the id's home slot, nothing else
+    void Prefetch(int id) const {
+        __builtin_prefetch(&slots[Hash(id)]);
+    }
+
+    uint32_t Erase(int id) {
+        size_t i = Hash(id);
+        while (slots[i].order != NO_ORDER && slots[i].id != id) {
+            i = (i + 1) & mask;
+        }
+
+        uint32_t found = slots[i].order;
+        if (found == NO_ORDER) return NO_ORDER;
+
+        //pull back every following entry that would no longer be reachable across the hole
+        size_t hole = i;
+        size_t j = i;
+        while (true) {
+            j = (j + 1) & mask;
+            if (slots[j].order == NO_ORDER) break;
+
+            size_t home = Hash(slots[j].id);
+            //entry at j can move to the hole only if its home is not in (hole, j]
+            if (((j - home) & mask) >= ((j - hole) & mask)) {
+                slots[hole] = slots[j];
+                hole = j;
+            }
+        }
+        slots[hole].order = NO_ORDER;
+        return found;
+    }
+
+private:
+    size_t Hash(int id) const {
+        //fibonacci hashing so sequential ids spread over the table
+        return (size_t)(((uint32_t)id * 2654435769u) >> shift) & mask;
+    }
+};
+
+// Start of a book's region. Also the header of a book image (the file behind a
+// persistent book): the layout the book was built with, plus the few counters that
+// live in the OrderBook object and are copied here by Checkpoint().
+struct BookImageHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t orderSize;
+    uint32_t infoSize;
+    uint64_t numLevels;
+    uint64_t maxOrders;
+    double tickSize;
+    int64_t baseTick;
+    int64_t bestBid;
+    int64_t bestAsk;
+    uint64_t nextSequence;
+    uint64_t checkpoints;
+    TypedPool<Order>::State orderPool;
+    TypedPool<PriceLevel>::State levelPool;
+    uint32_t clean; //1 from a Checkpoint() until the book changes again
+};
+
+const char BOOK_IMAGE_MAGIC[4] = { 'H', 'F', 'T', 'B' };
+const uint32_t BOOK_IMAGE_VERSION = 1;
+
+// Tick indexed book. levels[] is a contiguous window of price levels around the mid,
+// one slot per tick. Prices arrive in ticks, so the level of a price is one subtraction.
+// Bids and asks share the window: every bid level is below every ask level (the book
+// is never crossed after matching), so one bitmap of non-empty levels is enough to
+// move the best bid/ask cursors with a couple of bit scans.
+//
+// Everything the book holds (pools, cold order data, levels, bitmap, id index) is
+// carved in a fixed order from one region, and every link in it is an index, never a
+// pointer. Given an image path the region is a shared file mapping: Checkpoint()
+// makes the file a consistent copy of the book with one msync, and OpenImage() maps it
+// back, at any address, with no per-order work.
+class OrderBook {
+private:
+    LinearAllocator* region;
+    BookImageHeader* image; //start of the region
+    bool persistent;        //region is a file
+    bool imageClean;        //image->clean is set, the next change clears it
+
+    TypedPool<Order>* orderPool;
+    OrderInfo* orderInfo; //cold half of every order, same index as its pool slot
+    TypedPool<PriceLevel>* levelPool;
+    OrderIndex* orderIndex; //id -> slot of the resting order, for cancel/modify
+
+    uint32_t* levels; //level pool slot per tick, NO_LEVEL when nobody rests there
+    uint64_t* levelBitmap; //1 bit per level, set while the level has orders
+    long long numLevels;
+    long long numWords;
+
+    PriceScale scale; //only used to print prices
+    long long baseTick; //tick of levels[0]
+
+    long long bestBid; //-1 when there are no bids
+    long long bestAsk; //numLevels when there are no asks
+
+    uint64_t nextSequence;
+
+    EventLog* eventLog; //nullptr = no events, set for [TRADE]/[BOOK] lines
+    uint16_t logScale;  //slot of scale in eventLog
+
+#ifdef HFT_LATENCY_STATS
+    LatencyHistogram processLatency; //whole ProcessOrder call
+    LatencyHistogram poolLatency;    //every order/level pool Create and Destroy
+#endif
+
+public:
+    // imagePath: keep the book in that file (created or truncated) so it can be
+    // checkpointed. If the file can't be made the book says so and stays in memory.
+    OrderBook(double midPrice = 100.0, double tick = 0.01, size_t levelCount = 20000, size_t maxOrders = 100000,
+              const char* imagePath = nullptr) {
+        scale = PriceScale(tick);
+        numLevels = (long long)levelCount;
+        numWords = (numLevels + 63) / 64;
+        baseTick = scale.ToTicks(midPrice) - numLevels / 2;
+
+        MapRegion(maxOrders, imagePath, false, true);
+        if (region->GetStart() == nullptr && imagePath != nullptr) {
+            std::cerr << "[IMAGE] cannot create " << imagePath << ", the book is in memory only" << std::endl;
+            delete region;
+            MapRegion(maxOrders, nullptr, false, true);
+        }
+        BuildViews(maxOrders, true);
+
+        bestBid = -1;
+        bestAsk = numLevels;
+        nextSequence = 0;
+        eventLog = nullptr;
+        logScale = 0;
+
+        std::memset(image, 0, sizeof(BookImageHeader));
+        std::memcpy(image->magic, BOOK_IMAGE_MAGIC, 4);
+        image->version = BOOK_IMAGE_VERSION;
+        image->orderSize = sizeof(Order);
+        image->infoSize = sizeof(OrderInfo);
+        image->numLevels = (uint64_t)numLevels;
+        image->maxOrders = maxOrders;
+        image->tickSize = tick;
+        image->baseTick = baseTick;
+    }
+
+    ~OrderBook() {
+        delete orderIndex;
+        delete levelPool;
+        delete orderPool;
+        delete region; //unmaps, a persistent image stays as of the last write
+    }
+
+    // Book from an image written by Checkpoint(), nullptr (and a message on cerr) if the
+    // file is not one, or the book changed after its last checkpoint. Nothing is read
+    // per order: the file is mapped and the few counters come from its header.
+    // prefault reads the whole file in now (MAP_POPULATE) rather than on first touch.
+    // The restored book keeps the image: later checkpoints go to the same file.
+    static OrderBook* OpenImage(const char* path, bool prefault = true) {
+        BookImageHeader header;
+        if (!ReadImageHeader(path, header)) return nullptr;
+
+        OrderBook* book = new OrderBook(header, path, prefault);
+        if (book->region->GetStart() == nullptr || !book->persistent) {
+            std::cerr << "[IMAGE] cannot map " << path << std::endl;
+            delete book;
+            return nullptr;
+        }
+        return book;
+    }
+
+    // Persistent books: makes the image a consistent copy of the book as it is now.
+    // The region is synced first and only then is the header marked clean (and synced
+    // again), so an image is either complete or refused by OpenImage(). The image stays
+    // clean until the next change to the book; one that changed after its last
+    // checkpoint is refused, which is what a crashed process leaves behind.
+    bool Checkpoint() {
+        if (!persistent) return false;
+
+        image->bestBid = bestBid;
+        image->bestAsk = bestAsk;
+        image->nextSequence = nextSequence;
+        image->orderPool = orderPool->GetState();
+        image->levelPool = levelPool->GetState();
+        image->checkpoints++;
+        image->clean = 0;
+        if (!region->Sync()) return false;
+
+        image->clean = 1;
+        imageClean = true;
+        return region->Sync(0, sizeof(BookImageHeader));
+    }
+
+    bool IsPersistent() const { return persistent; }
+
+    //hot path so no 'new', no 'malloc'...
+    void ProcessOrder(int id, OrderType type, Price price, int quantity, int clientId = 0) {
+        HFT_LATENCY_SCOPE(processLatency);
+        if (imageClean) MarkDirty();
+
+        if (orderIndex->Find(id) != NO_ORDER) {
+            Emit(EVENT_REJECT_DUPLICATE, id);
+            return;
+        }
+
+        long long idx = PriceToIndex(price);
+
+        if (type == BUY) {
+            // Attempt to match with Sellers, cheapest level first.
+            // Anything above the window can only match what is inside it.
+            long long limit = std::min(idx, numLevels - 1);
+
+            while (quantity > 0 && bestAsk <= limit) {
+                uint32_t seller = levelPool->At(levels[bestAsk])->head;
+                Order* ord = orderPool->At(seller);
+
+                int tradeQty = std::min(quantity, ord->quantity);
+
+                //the seller's id lives in the cold half, only read when it is needed
+                if (eventLog != nullptr) Emit(EVENT_TRADE, id, 'B', IndexToPrice(bestAsk), tradeQty, orderInfo[seller].id);
+
+                quantity -= tradeQty;
+                ord->quantity -= tradeQty;
+
+                //remove filled sell order...
+                if (ord->quantity == 0) {
+                    orderIndex->Erase(orderInfo[seller].id);
+                    RemoveOrder(seller);
+                }
+            }
+        }
+
+        else {
+            // Attempt to match with Buyers, richest level first.
+            long long limit = std::max(idx, 0LL);
+
+            while (quantity > 0 && bestBid >= limit) {
+                uint32_t buyer = levelPool->At(levels[bestBid])->head;
+                Order* ord = orderPool->At(buyer);
+
+                int tradeQty = std::min(quantity, ord->quantity);
+
+                if (eventLog != nullptr) Emit(EVENT_TRADE, id, 'S', IndexToPrice(bestBid), tradeQty, orderInfo[buyer].id);
+
+                quantity -= tradeQty;
+                ord->quantity -= tradeQty;
+
+                // Remove filled buy order
+                if (ord->quantity == 0) {
+                    orderIndex->Erase(orderInfo[buyer].id);
+                    RemoveOrder(buyer);
+                }
+            }
+        }
+
+        // add rem to bookk...
+        if (quantity > 0) {
+            if (idx < 0 || idx >= numLevels) {
+                Emit(EVENT_REJECT_PRICE_BAND, id, type == BUY ? 'B' : 'S', price);
+                return;
+            }
+
+            uint32_t newOrder = NewOrder(id, type, (uint32_t)idx, quantity, clientId);
+            if (newOrder == NO_ORDER) {
+                Emit(EVENT_REJECT_ORDER_POOL, id);
+                return;
+            }
+
+            if (!AppendOrder(newOrder)) {
+                FreeOrder(newOrder);
+                Emit(EVENT_REJECT_LEVEL_POOL, id);
+                return;
+            }
+            orderIndex->Insert(id, newOrder);
+
+            if (type == BUY) {
+                if (idx > bestBid) bestBid = idx;
+                Emit(EVENT_BOOK, id, 'B', price, quantity);
+            } else {
+                if (idx < bestAsk) bestAsk = idx;
+                Emit(EVENT_BOOK, id, 'S', price, quantity);
+            }
+        }
+    }
+
+    bool CancelOrder(int id) {
+        if (imageClean) MarkDirty();
+        uint32_t slot = orderIndex->Erase(id);
+        if (slot == NO_ORDER) {
+            Emit(EVENT_REJECT_UNKNOWN_CANCEL, id);
+            return false;
+        }
+
+        RemoveOrder(slot);
+        Emit(EVENT_CANCEL, id);
+        return true;
+    }
+
+    // Reducing the quantity at the same price keeps the queue position.
+    // A new price (or a bigger quantity) loses priority: the order is pulled and
+    // processed again as a fresh one, so it can also trade if it now crosses.
+    bool ModifyOrder(int id, Price newPrice, int newQty) {
+        if (newQty <= 0) return CancelOrder(id);
+        if (imageClean) MarkDirty();
+
+        uint32_t slot = orderIndex->Find(id);
+        if (slot == NO_ORDER) {
+            Emit(EVENT_REJECT_UNKNOWN_MODIFY, id);
+            return false;
+        }
+
+        Order* ord = orderPool->At(slot);
+        const OrderInfo& info = orderInfo[slot];
+        if (PriceToIndex(newPrice) == (long long)ord->level && newQty <= ord->quantity) {
+            ord->quantity = newQty;
+            Emit(EVENT_REDUCE, id, info.type == BUY ? 'B' : 'S', IndexToPrice(ord->level), newQty);
+            return true;
+        }
+
+        OrderType type = info.type;
+        int clientId = info.clientId;
+        orderIndex->Erase(id);
+        RemoveOrder(slot);
+
+        Emit(EVENT_REQUEUE, id, type == BUY ? 'B' : 'S', newPrice, newQty);
+        ProcessOrder(id, type, newPrice, newQty, clientId);
+        return true;
+    }
+
+    //decoded message of any type, the symbol is already routed...
+    void ProcessMessage(const IncomingMessage& msg) {
+        switch (msg.type) {
+        case 'C':
+            CancelOrder(msg.orderId);
+            break;
+        case 'M':
+            ModifyOrder(msg.orderId, msg.price, msg.qty);
+            break;
+        default:
+            ProcessOrder(msg.orderId, (msg.side == 'B') ? BUY : SELL, msg.price, msg.qty, msg.clientId);
+            break;
+        }
+    }
+
+    // Same result as ProcessMessage on every message in turn: they are still applied one by
+    // one and in order, lookups are never reused across messages. What the batch buys is
+    // lookahead. The id's index slot and the level pointer are prefetched
+    // BATCH_INDEX_AHEAD messages early; BATCH_ORDER_AHEAD messages early (by then the
+    // index line is in cache) the resting order of a cancel/modify or the level a new
+    // order joins is prefetched. So the dependent loads of the next messages overlap
+    // the matching of this one instead of each message stalling on its own chain.
+    void ProcessBatch(const IncomingMessage* msgs, size_t n) {
+        //message 0 is processed right away, prefetching it would only cost
+        for (size_t i = 1; i < n && i < BATCH_INDEX_AHEAD; ++i) PrefetchIndex(msgs[i]);
+        for (size_t i = 1; i < n && i < BATCH_ORDER_AHEAD; ++i) PrefetchOrder(msgs[i]);
+
+        for (size_t i = 0; i < n; ++i) {
+            if (i + BATCH_INDEX_AHEAD < n) PrefetchIndex(msgs[i + BATCH_INDEX_AHEAD]);
+            if (i + BATCH_ORDER_AHEAD < n) PrefetchOrder(msgs[i + BATCH_ORDER_AHEAD]);
+            ProcessMessage(msgs[i]);
+        }
+    }
+
+    static const size_t BATCH_INDEX_AHEAD = 8;
+    static const size_t BATCH_ORDER_AHEAD = 4;
+
+    //events go to log (which outlives the book), nullptr turns them off
+    void SetEventLog(EventLog* log) {
+        eventLog = log;
+        logScale = log != nullptr ? log->AddScale(scale) : 0;
+    }
+
+    bool HasBids() const { return bestBid >= 0; }
+    bool HasAsks() const { return bestAsk < numLevels; }
+    Price GetBestBid() const { return IndexToPrice(bestBid); }
+    Price GetBestAsk() const { return IndexToPrice(bestAsk); }
+    const PriceScale& GetPriceScale() const { return scale; }
+    size_t GetNumOrders() const { return orderPool->Size(); }
+    size_t GetNumLevels() const { return levelPool->Size(); }
+
+    //pool telemetry, safe to poll from a monitoring thread (false without HFT_ALLOCATOR_STATS)
+    bool GetOrderPoolSnapshot(AllocatorSnapshot& out) const { return orderPool->GetSnapshot(out); }
+    bool GetLevelPoolSnapshot(AllocatorSnapshot& out) const { return levelPool->GetSnapshot(out); }
+
+    //cold data of a resting order, nullptr if the id is not in the book
+    const OrderInfo* GetOrderInfo(int id) const {
+        uint32_t slot = orderIndex->Find(id);
+        return slot == NO_ORDER ? nullptr : &orderInfo[slot];
+    }
+
+#ifdef HFT_LATENCY_STATS
+    const LatencyHistogram& GetProcessLatency() const { return processLatency; }
+    const LatencyHistogram& GetPoolLatency() const { return poolLatency; }
+
+    void ResetLatency() {
+        processLatency.Reset();
+        poolLatency.Reset();
+    }
+#endif
+
+private:
+    //restored book, see OpenImage()
+    OrderBook(const BookImageHeader& header, const char* path, bool prefault) {
+        scale = PriceScale(header.tickSize);
+        numLevels = (long long)header.numLevels;
+        numWords = (numLevels + 63) / 64;
+        baseTick = header.baseTick;
+        eventLog = nullptr;
+        logScale = 0;
+
+        MapRegion((size_t)header.maxOrders, path, true, prefault);
+        if (region->GetStart() == nullptr) {
+            //OpenImage() deletes it, the destructor needs every pointer
+            orderIndex = nullptr;
+            levelPool = nullptr;
+            orderPool = nullptr;
+            return;
+        }
+        BuildViews((size_t)header.maxOrders, false);
+
+        bestBid = image->bestBid;
+        bestAsk = image->bestAsk;
+        nextSequence = image->nextSequence;
+        orderPool->SetState(image->orderPool);
+        levelPool->SetState(image->levelPool);
+        imageClean = true;
+    }
+
+    //offsets of everything in the region, from the start of the header
+    struct Layout {
+        size_t orders, info, levelSlots, levels, bitmap, index, total;
+    };
+
+    static size_t CacheLines(size_t bytes) { return (bytes + 63) & ~(size_t)63; }
+
+    static Layout LayoutFor(size_t numLevels, size_t maxOrders) {
+        Layout l;
+        size_t at = CacheLines(sizeof(BookImageHeader));
+        l.orders = at;
+        at += CacheLines(TypedPool<Order>::MemoryFor(maxOrders));
+        l.info = at;
+        at += CacheLines(maxOrders * sizeof(OrderInfo));
+        l.levelSlots = at;
+        at += CacheLines(TypedPool<PriceLevel>::MemoryFor(numLevels)); //at most one level object per tick
+        l.levels = at;
+        at += CacheLines(numLevels * sizeof(uint32_t));
+        l.bitmap = at;
+        at += CacheLines((numLevels + 63) / 64 * sizeof(uint64_t));
+        l.index = at;
+        at += CacheLines(OrderIndex::MemoryFor(maxOrders));
+        l.total = at;
+        return l;
+    }
+
+    // In memory: huge pages and prefaulted so the first orders of the day don't take
+    // page faults. In a file: 4K pages (the page cache has no huge ones), read in up
+    // front when prefault is set.
+    void MapRegion(size_t maxOrders, const char* path, bool keep, bool prefault) {
+        Layout l = LayoutFor((size_t)numLevels, maxOrders);
+        region = new LinearAllocator(l.total + 64); //+ room to align a malloc'ed start
+        if (path != nullptr) {
+            region->SetBackingFile(path, keep);
+            region->SetBackingMemory(prefault ? MEM_PREFAULT : MEM_HEAP);
+        } else {
+            region->SetBackingMemory(MEM_HUGE_PAGES | MEM_PREFAULT);
+        }
+        region->Init();
+        persistent = (region->GetBackingMemory() & MEM_FILE) != 0;
+        imageClean = false;
+        image = (BookImageHeader*)region->Allocate(l.total, 64);
+    }
+
+    void BuildViews(size_t maxOrders, bool fresh) {
+        Layout l = LayoutFor((size_t)numLevels, maxOrders);
+        char* base = (char*)image;
+
+        orderPool = new TypedPool<Order>(base + l.orders, maxOrders);
+        orderInfo = (OrderInfo*)(base + l.info);
+        levelPool = new TypedPool<PriceLevel>(base + l.levelSlots, (size_t)numLevels);
+        levels = (uint32_t*)(base + l.levels);
+        levelBitmap = (uint64_t*)(base + l.bitmap);
+        orderIndex = new OrderIndex(maxOrders, base + l.index, fresh);
+
+        if (fresh) {
+            std::memset(levels, 0xFF, numLevels * sizeof(uint32_t)); //NO_LEVEL
+            std::memset(levelBitmap, 0, numWords * sizeof(uint64_t));
+        }
+    }
+
+    static bool ReadImageHeader(const char* path, BookImageHeader& header) {
+#ifdef __linux__
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "[IMAGE] cannot open " << path << std::endl;
+            return false;
+        }
+        ssize_t got = pread(fd, &header, sizeof(header), 0);
+        close(fd);
+
+        if (got != (ssize_t)sizeof(header) || std::memcmp(header.magic, BOOK_IMAGE_MAGIC, 4) != 0) {
+            std::cerr << "[IMAGE] " << path << " is not a book image" << std::endl;
+            return false;
+        }
+        if (header.version != BOOK_IMAGE_VERSION || header.orderSize != sizeof(Order) || header.infoSize != sizeof(OrderInfo)) {
+            std::cerr << "[IMAGE] " << path << " was written with another order layout (version " << header.version << ")" << std::endl;
+            return false;
+        }
+        if (header.clean != 1) {
+            std::cerr << "[IMAGE] " << path << " changed after its last checkpoint, replay instead" << std::endl;
+            return false;
+        }
+        return true;
+#else
+        (void)header;
+        std::cerr << "[IMAGE] book images need mmap, cannot open " << path << std::endl;
+        return false;
+#endif
+    }
+
+    //first change after a checkpoint, the image no longer matches a consistent book
+    void MarkDirty() {
+        image->clean = 0;
+        imageClean = false;
+    }
+
+    long long PriceToIndex(Price price) const {
+        return price - baseTick;
+    }
+
+    Price IndexToPrice(long long idx) const {
+        return baseTick + idx;
+    }
+
+    //first stage of ProcessBatch, only touches lines that don't depend on book state
+    void PrefetchIndex(const IncomingMessage& msg) const {
+        orderIndex->Prefetch(msg.orderId);
+        if (msg.type == 'C') return;
+
+        long long idx = PriceToIndex(msg.price);
+        if (idx >= 0 && idx < numLevels) __builtin_prefetch(&levels[idx]);
+    }
+
+    //second stage: one read-only lookup, whatever it finds is only a hint
+    void PrefetchOrder(const IncomingMessage& msg) const {
+        if (msg.type == 'C' || msg.type == 'M') {
+            uint32_t slot = orderIndex->Find(msg.orderId);
+            if (slot != NO_ORDER) __builtin_prefetch(orderPool->At(slot));
+            return;
+        }
+
+        long long idx = PriceToIndex(msg.price);
+        if (idx < 0 || idx >= numLevels || levels[idx] == NO_LEVEL) return;
+        PriceLevel* level = levelPool->At(levels[idx]);
+        __builtin_prefetch(level);
+        if (level->tail != NO_ORDER) __builtin_prefetch(orderPool->At(level->tail));
+    }
+
+    //prices go out in ticks, the log thread formats them with this book's scale
+    void Emit(uint8_t kind, int id, char side = 0, Price price = 0, int qty = 0, int otherId = 0) {
+        if (eventLog == nullptr) return;
+        ExecutionEvent event;
+        event.kind = kind;
+        event.side = side;
+        event.scale = logScale;
+        event.orderId = id;
+        event.otherId = otherId;
+        event.qty = qty;
+        event.price = price;
+        eventLog->Push(event);
+    }
+
+    //slot of the new order, NO_ORDER when the pool is full
+    uint32_t NewOrder(int id, OrderType type, uint32_t idx, int quantity, int clientId) {
+        HFT_LATENCY_SCOPE(poolLatency);
+        Order* ord = orderPool->Create(quantity, idx);
+        if (ord == nullptr) return NO_ORDER;
+
+        uint32_t slot = orderPool->IndexOf(ord);
+        OrderInfo& info = orderInfo[slot];
+        info.id = id;
+        info.clientId = clientId;
+        info.sequence = nextSequence++;
+        info.type = type;
+        return slot;
+    }
+
+    void FreeOrder(uint32_t slot) {
+        HFT_LATENCY_SCOPE(poolLatency);
+        orderPool->Destroy(orderPool->At(slot));
+    }
+
+    PriceLevel* NewLevel() {
+        HFT_LATENCY_SCOPE(poolLatency);
+        return levelPool->Create();
+    }
+
+    void FreeLevel(PriceLevel* level) {
+        HFT_LATENCY_SCOPE(poolLatency);
+        levelPool->Destroy(level);
+    }
+
+    // Add to the back of the level queue (time priority), creating the level if needed
+    bool AppendOrder(uint32_t slot) {
+        Order* ord = orderPool->At(slot);
+        long long idx = ord->level;
+        PriceLevel* level;
+
+        if (levels[idx] == NO_LEVEL) {
+            level = NewLevel();
+            if (level == nullptr) return false;
+
+            levels[idx] = levelPool->IndexOf(level);
+            levelBitmap[idx >> 6] |= (1ULL << (idx & 63));
+        } else {
+            level = levelPool->At(levels[idx]);
+        }
+
+        ord->prev = level->tail;
+        if (level->tail != NO_ORDER) orderPool->At(level->tail)->next = slot;
+        else level->head = slot;
+        level->tail = slot;
+        return true;
+    }
+
+    // Unlink from its level (any position), free it, and drop the level if it is now empty
+    void RemoveOrder(uint32_t slot) {
+        Order* ord = orderPool->At(slot);
+        long long idx = ord->level;
+        PriceLevel* level = levelPool->At(levels[idx]);
+
+        if (ord->prev != NO_ORDER) orderPool->At(ord->prev)->next = ord->next;
+        else level->head = ord->next;
+        if (ord->next != NO_ORDER) orderPool->At(ord->next)->prev = ord->prev;
+        else level->tail = ord->prev;
+
+        FreeOrder(slot);
+
+        if (level->head == NO_ORDER) {
+            RemoveLevel(idx);
+            if (idx == bestBid) bestBid = FindLevelBelow(idx - 1);
+            if (idx == bestAsk) bestAsk = FindLevelAbove(idx + 1);
+        }
+    }
+
+    void RemoveLevel(long long idx) {
+        PriceLevel* level = levelPool->At(levels[idx]);
+        levels[idx] = NO_LEVEL;
+        levelBitmap[idx >> 6] &= ~(1ULL << (idx & 63));
+
+        FreeLevel(level);
+    }
+
+    //lowest non-empty level >= from, numLevels if none...
+    long long FindLevelAbove(long long from) const {
+        if (from >= numLevels) return numLevels;
+
+        long long word = from >> 6;
+        uint64_t bits = levelBitmap[word] & (~0ULL << (from & 63));
+
+        while (bits == 0) {
+            if (++word >= numWords) return numLevels;
+            bits = levelBitmap[word];
+        }
+        return (word << 6) + __builtin_ctzll(bits);
+    }
+
+    //highest non-empty level <= from, -1 if none...
+    long long FindLevelBelow(long long from) const {
+        if (from < 0) return -1;
+
+        long long word = from >> 6;
+        uint64_t bits = levelBitmap[word] & (~0ULL >> (63 - (from & 63)));
+
+        while (bits == 0) {
+            if (--word < 0) return -1;
+            bits = levelBitmap[word];
+        }
+        return (word << 6) + 63 - __builtin_clzll(bits);
+    }
+};
+
+#endif
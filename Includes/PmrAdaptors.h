@@ -0,0 +1,155 @@
+#ifndef PMR_ADAPTORS_H
+#define PMR_ADAPTORS_H
+
+#include <memory_resource>
+#include <new>
+#include <cstddef>
+
+#include "Allocator.h"
+#include "StackAllocator.h"
+#include "PoolAllocator.h"
+
+// Glue so standard containers can live in our allocators instead of the global heap.
+//  - AllocatorResource: std::pmr::memory_resource over any Allocator whose Deallocate
+//    accepts blocks in any order (Linear, FreeList, TLSF, Buddy...). Linear never
+//    frees, so a container on it is reclaimed by Reset() once the container is gone.
+//  - PoolResource: requests up to the chunk size go to a PoolAllocator, bigger ones
+//    (vector buffers, bucket arrays) go to the upstream resource.
+//  - StackResource: a StackAllocator only frees its top block. Containers free out of
+//    order (a vector frees the old buffer after allocating the new one), so only a
+//    free of the most recent block gives memory back, anything else waits for Reset().
+//  - StlAllocator<T>: the classic Allocator requirements over an Allocator*, for code
+//    that takes an allocator template argument instead of a pmr resource. Same rule as
+//    AllocatorResource: blocks are freed in any order (a growing vector frees its old
+//    buffer under the new one), so a StackAllocator is refused at compile time; use a
+//    StackResource for that. One passed as a plain Allocator* can't be caught, so don't.
+// All of them throw std::bad_alloc when the allocator is out of memory, as the
+// standard containers expect.
+
+class AllocatorResource : public std::pmr::memory_resource {
+protected:
+    Allocator* m_allocator;
+
+public:
+    explicit AllocatorResource(Allocator* allocator) : m_allocator(allocator) {}
+
+    Allocator* GetAllocator() const { return m_allocator; }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        void* ptr = m_allocator->Allocate(bytes, alignment);
+        if (ptr == nullptr) throw std::bad_alloc();
+        return ptr;
+    }
+
+    void do_deallocate(void* ptr, size_t, size_t) override {
+        m_allocator->Deallocate(ptr);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+class PoolResource : public std::pmr::memory_resource {
+private:
+    PoolAllocator* m_pool;
+    size_t m_chunk_size;
+    size_t m_alignment;
+    std::pmr::memory_resource* m_upstream;
+
+public:
+    explicit PoolResource(PoolAllocator* pool, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : m_pool(pool), m_chunk_size(pool->GetChunkSize()), m_alignment(pool->GetAlignment()), m_upstream(upstream) {}
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        if (bytes > m_chunk_size || alignment > m_alignment) {
+            return m_upstream->allocate(bytes, alignment);
+        }
+        void* ptr = m_pool->Allocate(bytes, alignment);
+        if (ptr == nullptr) throw std::bad_alloc();
+        return ptr;
+    }
+
+    //pmr hands the size back on free, so the same test picks the same side
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+        if (bytes > m_chunk_size || alignment > m_alignment) {
+            m_upstream->deallocate(ptr, bytes, alignment);
+            return;
+        }
+        m_pool->Deallocate(ptr);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+class StackResource : public std::pmr::memory_resource {
+private:
+    StackAllocator* m_stack;
+    void* m_top; //last block handed out, nullptr once it was freed
+
+public:
+    explicit StackResource(StackAllocator* stack) : m_stack(stack), m_top(nullptr) {}
+
+    //call instead of StackAllocator::Reset() so the resource forgets its top too
+    void Reset() {
+        m_stack->Reset();
+        m_top = nullptr;
+    }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        void* ptr = m_stack->Allocate(bytes, alignment);
+        if (ptr == nullptr) throw std::bad_alloc();
+        m_top = ptr;
+        return ptr;
+    }
+
+    void do_deallocate(void* ptr, size_t, size_t) override {
+        if (ptr == m_top) {
+            m_stack->Deallocate(ptr);
+            m_top = nullptr;
+        }
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+template <typename T>
+class StlAllocator {
+public:
+    typedef T value_type;
+
+    Allocator* m_allocator;
+
+    explicit StlAllocator(Allocator* allocator) noexcept : m_allocator(allocator) {}
+
+    //frees are not LIFO, see the top of the file
+    explicit StlAllocator(StackAllocator* stack) = delete;
+
+    template <typename U>
+    StlAllocator(const StlAllocator<U>& other) noexcept : m_allocator(other.m_allocator) {}
+
+    T* allocate(size_t n) {
+        void* ptr = m_allocator->Allocate(n * sizeof(T), alignof(T));
+        if (ptr == nullptr) throw std::bad_alloc();
+        return (T*)ptr;
+    }
+
+    void deallocate(T* ptr, size_t) noexcept {
+        m_allocator->Deallocate(ptr);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const StlAllocator<T>& a, const StlAllocator<U>& b) noexcept { return a.m_allocator == b.m_allocator; }
+
+template <typename T, typename U>
+bool operator!=(const StlAllocator<T>& a, const StlAllocator<U>& b) noexcept { return a.m_allocator != b.m_allocator; }
+
+#endif
@@ -2,62 +2,84 @@
 #define POOL_ALLOCATOR_H
 
 #include "Allocator.h"
+#include "LinearAllocator.h"
 #include <cstdlib>
+#include <vector>
 
+// Fixed size chunks. Chunks that were never handed out are taken from a bump pointer,
+// the free list only holds chunks that came back through Deallocate, so Init()/Reset()
+// don't walk (and fault in) the whole region.
+// A growable pool adds another slab of the same size when both run dry instead of
+// returning nullptr. Extra slabs use the same backing memory and go away on Reset().
 class PoolAllocator : public Allocator {
 private:
     struct FreeHeader {
         FreeHeader* next;
     };
 
-    FreeHeader* m_free_list_head; 
+    FreeHeader* m_free_list_head;
     size_t m_chunk_size;
     size_t m_alignment;
 
+    uintptr_t m_bump; //next never used chunk
+    uintptr_t m_end;  //end of the slab m_bump is in
+
+    bool m_growable;
+    std::vector<LinearAllocator*> m_slabs; //grown slabs, the first region is m_start_ptr
+
 public:
-    PoolAllocator(size_t totalSize, size_t chunkSize, size_t alignment = 8) 
-        : Allocator(totalSize), m_chunk_size(chunkSize), m_alignment(alignment) {
-            
+    PoolAllocator(size_t totalSize, size_t chunkSize, size_t alignment = 8, bool growable = false)
+        : Allocator(totalSize), m_free_list_head(nullptr), m_chunk_size(chunkSize), m_alignment(alignment),
+          m_bump(0), m_end(0), m_growable(growable) {
+
         if (m_chunk_size < sizeof(FreeHeader*)) {
             m_chunk_size = sizeof(FreeHeader*);
         }
-        
+
         //align the chunk size so every block starts at an aligned address...ex if 10 then make chunk as 16 if align is 8
         size_t mask = m_alignment - 1;
         if (m_chunk_size & mask) {
              m_chunk_size += m_alignment - (m_chunk_size & mask);
         }
+        StatsConfigure(AllocatorStats::FREE_CHUNKS, m_chunk_size);
     }
 
     void Init() override {
-        if (m_start_ptr != nullptr) free(m_start_ptr);
-        m_start_ptr = malloc(m_total_size);
-        
-        Reset(); //build LL
+        ReleaseMemory();
+        m_start_ptr = AcquireMemory(m_total_size);
+
+        Reset();
     }
 
     ~PoolAllocator() {
-        if (m_start_ptr != nullptr) free(m_start_ptr);
+        ReleaseSlabs();
+        ReleaseMemory();
     }
 
     void* Allocate(size_t size, size_t alignment = 8) override {
 
-        if (m_free_list_head == nullptr) {
-            return nullptr; 
-        }
-
         FreeHeader* free_block = m_free_list_head;
 
-        m_free_list_head = m_free_list_head->next;
+        if (free_block != nullptr) {
+            m_free_list_head = m_free_list_head->next;
+        } else {
+            if (m_bump + m_chunk_size > m_end && !Grow()) {
+                StatsFailed();
+                return nullptr;
+            }
+            free_block = (FreeHeader*)m_bump;
+            m_bump += m_chunk_size;
+        }
 
         m_used_memory += m_chunk_size;
         m_num_allocations++;
+        StatsAllocated(size);
 
         return (void*)free_block;
     }
 
     void Deallocate(void* ptr) override {
-        
+
         FreeHeader* header = (FreeHeader*)ptr;
 
         header->next = m_free_list_head;
@@ -66,28 +88,52 @@ public:
 
         m_used_memory -= m_chunk_size;
         m_num_allocations--;
+        StatsFreed();
     }
 
+    //O(1) apart from unmapping grown slabs
     void Reset() override {
         m_used_memory = 0;
         m_num_allocations = 0;
 
-        size_t nChunks = m_total_size / m_chunk_size;
+        ReleaseSlabs();
 
-        m_free_list_head = (FreeHeader*)m_start_ptr;
-        FreeHeader* current = m_free_list_head;
+        m_free_list_head = nullptr;
+        m_bump = (uintptr_t)m_start_ptr;
+        m_end = m_bump + (m_total_size / m_chunk_size) * m_chunk_size;
+
+        StatsFreed();
+        StatsChunks(m_total_size / m_chunk_size);
+    }
 
-        for (size_t i = 0; i < nChunks - 1; ++i) {
+    size_t GetNumSlabs() const { return 1 + m_slabs.size(); }
+    size_t GetChunkSize() const { return m_chunk_size; }
+    size_t GetAlignment() const { return m_alignment; }
 
-            uintptr_t next_addr = (uintptr_t)current + m_chunk_size;
-        
-            current->next = (FreeHeader*)next_addr;
-            
-            current = current->next;
+private:
+    //slow path: only runs when the pool is exhausted
+    bool Grow() {
+        if (!m_growable) return false;
+
+        LinearAllocator* slab = new LinearAllocator(m_total_size);
+        slab->SetBackingMemory(m_backing_requested);
+        slab->Init();
+        if (slab->GetStart() == nullptr) {
+            delete slab;
+            return false;
         }
+        m_slabs.push_back(slab);
+
+        m_bump = (uintptr_t)slab->GetStart();
+        m_end = m_bump + (m_total_size / m_chunk_size) * m_chunk_size;
+        StatsChunks(GetNumSlabs() * (m_total_size / m_chunk_size));
+        return true;
+    }
 
-        current->next = nullptr;
+    void ReleaseSlabs() {
+        for (size_t i = 0; i < m_slabs.size(); ++i) delete m_slabs[i];
+        m_slabs.clear();
     }
 };
 
-#endif
\ No newline at end of file
+#endif
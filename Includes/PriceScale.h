@@ -0,0 +1,22 @@
+#ifndef PRICE_SCALE_H
+#define PRICE_SCALE_H
+
+#include <cstdint>
+#include <cmath>
+
+// Prices are whole ticks from the decoded message through matching to the fills, so
+// comparisons are integer compares and equal prices are equal. Every symbol has its own
+// scale (tick size); decimals only exist at the edges: the gateway converts the wire
+// price with ToTicks, the event log prints ToDouble.
+typedef int64_t Price;
+
+struct PriceScale {
+    double tickSize;
+
+    explicit PriceScale(double tick = 0.01) : tickSize(tick) {}
+
+    Price ToTicks(double price) const { return (Price)std::llround(price / tickSize); }
+    double ToDouble(Price ticks) const { return (double)ticks * tickSize; }
+};
+
+#endif
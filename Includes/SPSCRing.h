@@ -0,0 +1,91 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+
+// Lock-free single producer / single consumer ring of fixed size slots.
+// The producer owns m_head and the consumer owns m_tail; each side only reads the
+// other's index when its cached copy says the ring looks full/empty, so in steady
+// state the two threads don't bounce a cache line per message. Indices are padded
+// onto separate cache lines for the same reason.
+// Slots are written in place (TryClaim/Publish) and read in place (ConsumeBatch),
+// nothing is allocated or reset per message.
+template <typename T, size_t Capacity>
+class SPSCRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+private:
+    static const size_t CACHE_LINE = 64;
+    static const size_t MASK = Capacity - 1;
+
+    //producer side...
+    alignas(CACHE_LINE) std::atomic<size_t> m_head;
+    size_t m_cached_tail;
+
+    //consumer side...
+    alignas(CACHE_LINE) std::atomic<size_t> m_tail;
+    size_t m_cached_head;
+
+    alignas(CACHE_LINE) T m_slots[Capacity];
+
+public:
+    SPSCRing() : m_head(0), m_cached_tail(0), m_tail(0), m_cached_head(0) {}
+
+    SPSCRing(const SPSCRing&) = delete;
+    SPSCRing& operator=(const SPSCRing&) = delete;
+
+    // Producer: slot to fill, or nullptr when the ring is full. Nothing is visible
+    // to the consumer until Publish().
+    T* TryClaim() {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_cached_tail == Capacity) {
+            m_cached_tail = m_tail.load(std::memory_order_acquire);
+            if (head - m_cached_tail == Capacity) return nullptr;
+        }
+        return &m_slots[head & MASK];
+    }
+
+    void Publish() {
+        m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    bool TryPush(const T& item) {
+        T* slot = TryClaim();
+        if (slot == nullptr) return false;
+        *slot = item;
+        Publish();
+        return true;
+    }
+
+    // Consumer: hands up to maxBatch messages to fn(const T&) in order, then frees
+    // all of those slots with a single store. Returns how many were consumed.
+    template <typename F>
+    size_t ConsumeBatch(F&& fn, size_t maxBatch = Capacity) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        size_t available = m_cached_head - tail;
+
+        if (available == 0) {
+            m_cached_head = m_head.load(std::memory_order_acquire);
+            available = m_cached_head - tail;
+            if (available == 0) return 0;
+        }
+        if (available > maxBatch) available = maxBatch;
+
+        for (size_t i = 0; i < available; ++i) {
+            fn(m_slots[(tail + i) & MASK]);
+        }
+
+        m_tail.store(tail + available, std::memory_order_release);
+        return available;
+    }
+
+    //approximate when called while the other side is running...
+    size_t Size() const {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+    }
+
+    bool Empty() const { return Size() == 0; }
+};
+
+#endif
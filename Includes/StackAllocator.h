@@ -13,16 +13,18 @@ protected:
     };
 
 public:
-    StackAllocator(size_t totalSize) : Allocator(totalSize) {}
+    StackAllocator(size_t totalSize) : Allocator(totalSize) {
+        StatsConfigure(AllocatorStats::FREE_TAIL);
+    }
 
     void Init() override {
-        if (m_start_ptr != nullptr) free(m_start_ptr);
-        m_start_ptr = malloc(m_total_size);
+        ReleaseMemory();
+        m_start_ptr = AcquireMemory(m_total_size);
         m_current_pos = m_start_ptr;
     }
 
     ~StackAllocator() {
-        if (m_start_ptr != nullptr) free(m_start_ptr);
+        ReleaseMemory();
     }
 
     void* Allocate(size_t size, size_t alignment = 8) override {
@@ -47,6 +49,7 @@ public:
         size_t total_alloc_size = sizeof(AllocationHeader) + needed_padding + size;
 
         if (m_used_memory + total_alloc_size > m_total_size) {
+            StatsFailed();
             return nullptr;
         }
 
@@ -59,6 +62,7 @@ public:
         m_current_pos = (void*)(data_address + size);
         m_used_memory += total_alloc_size;
         m_num_allocations++;
+        StatsAllocated(size);
 
         return (void*)data_address;
     }
@@ -77,12 +81,14 @@ public:
         
         m_used_memory = m_used_memory - (current_top - block_start);
         m_num_allocations--;
+        StatsFreed();
     }
 
     void Reset() override {
         m_current_pos = m_start_ptr;
         m_used_memory = 0;
         m_num_allocations = 0;
+        StatsFreed();
     }
 };
 
@@ -0,0 +1,279 @@
+#ifndef TLSF_ALLOCATOR_H
+#define TLSF_ALLOCATOR_H
+
+#include "Allocator.h"
+#include <cstdlib>
+#include <iostream>
+
+// Two-Level Segregated Fit. Free blocks are kept in FL x SL lists: the first level is
+// the power of two of the size, the second level splits every power of two into
+// SL_COUNT equal ranges. Two bitmaps (one word for the first level, one word per first
+// level for the second) say which lists are non-empty, so finding a block is at most
+// two bit scans, and every block carries boundary tags, so freeing and merging with
+// both neighbours is O(1) too. No loop in Allocate/Deallocate depends on the number
+// of blocks: the worst case is bounded, which is what we want on the hot path.
+//
+// Block layout (same idea as FreeListAllocator's SEGREGATED_FIT):
+//   used: [tag][padding][AllocationHeader][payload...]
+//   free: [tag][prevFree][nextFree] ... [footer]
+class TLSFAllocator : public Allocator {
+private:
+    static const int SL_LOG2 = 4;
+    static const int SL_COUNT = 1 << SL_LOG2;
+    static const int FL_SHIFT = SL_LOG2 + 4;          //sizes below 2^FL_SHIFT (256) share first level 0
+    static const size_t SMALL_BLOCK = (size_t)1 << FL_SHIFT;
+    static const int FL_COUNT = 64 - FL_SHIFT + 1;
+
+    static const size_t TAG_USED = 1;      //this block is allocated
+    static const size_t TAG_PREV_USED = 2; //the block physically before this one is allocated
+    static const size_t TAG_FLAGS = 7;
+
+    struct AllocationHeader {
+        size_t size; //same value as the block tag
+        size_t padding;
+    };
+
+    struct FreeBlock {
+        size_t tag;
+        FreeBlock* prevFree;
+        FreeBlock* nextFree;
+    };
+
+    static const size_t MIN_BLOCK = sizeof(FreeBlock) + sizeof(size_t); //+ footer
+
+    uint64_t m_fl_bitmap;
+    uint32_t m_sl_bitmap[FL_COUNT];
+    FreeBlock* m_blocks[FL_COUNT][SL_COUNT];
+
+public:
+    TLSFAllocator(size_t totalSize) : Allocator(totalSize), m_fl_bitmap(0) {
+        StatsConfigure(AllocatorStats::FREE_TRACKED);
+    }
+
+    void Init() override {
+        ReleaseMemory();
+        m_start_ptr = AcquireMemory(m_total_size);
+
+        Reset();
+    }
+
+    ~TLSFAllocator() {
+        ReleaseMemory();
+    }
+
+    void* Allocate(size_t size, size_t alignment = 8) override {
+        //worst case padding when the block start is only 8 aligned, rounded so blocks stay 8 aligned
+        size_t worst = size + sizeof(AllocationHeader) + (alignment > 8 ? alignment - 8 : 0);
+        worst = (worst + 7) & ~(size_t)7;
+        if (worst < MIN_BLOCK) worst = MIN_BLOCK;
+
+        FreeBlock* block = FindSuitable(worst);
+        if (block == nullptr) {
+            std::cout << "TLSFAllocator: No block big enough found!" << std::endl;
+            StatsFailed();
+            return nullptr;
+        }
+        RemoveFree(block);
+
+        uintptr_t start = (uintptr_t)block;
+        size_t block_size = block->tag & ~TAG_FLAGS;
+        size_t prev_used = block->tag & TAG_PREV_USED;
+
+        uintptr_t header_end = start + sizeof(AllocationHeader);
+        size_t padding = 0;
+        size_t mask = alignment - 1;
+        if (header_end & mask) {
+            padding = alignment - (header_end & mask);
+        }
+
+        size_t required_space = (size + padding + sizeof(AllocationHeader) + 7) & ~(size_t)7;
+        if (required_space < MIN_BLOCK) required_space = MIN_BLOCK;
+
+        size_t remaining = block_size - required_space;
+        if (remaining >= MIN_BLOCK) {
+            //SPLIT: give the tail back, its predecessor (us) is now in use
+            MakeFree(start + required_space, remaining, TAG_PREV_USED);
+        } else {
+            required_space = block_size;
+            TagAt(start + block_size) |= TAG_PREV_USED;
+        }
+
+        size_t tag = required_space | TAG_USED | prev_used;
+        TagAt(start) = tag;
+
+        AllocationHeader* header = (AllocationHeader*)(start + padding);
+        header->size = tag;
+        header->padding = padding;
+
+        m_used_memory += required_space;
+        m_num_allocations++;
+        StatsAllocated(size);
+        PublishFreeBlocks();
+
+        return (void*)((uintptr_t)header + sizeof(AllocationHeader));
+    }
+
+    void Deallocate(void* ptr) override {
+        AllocationHeader* header = (AllocationHeader*)((uintptr_t)ptr - sizeof(AllocationHeader));
+        uintptr_t start = (uintptr_t)header - header->padding;
+
+        size_t tag = TagAt(start);
+        size_t block_size = tag & ~TAG_FLAGS;
+        size_t size = block_size;
+        size_t prev_used = tag & TAG_PREV_USED;
+
+        uintptr_t next = start + block_size;
+        size_t next_tag = TagAt(next);
+        if (!(next_tag & TAG_USED)) {
+            RemoveFree((FreeBlock*)next);
+            size += next_tag & ~TAG_FLAGS;
+        } else {
+            TagAt(next) = next_tag & ~TAG_PREV_USED;
+        }
+
+        if (!prev_used) {
+            size_t prev_size = *(size_t*)(start - sizeof(size_t));
+            start -= prev_size;
+            RemoveFree((FreeBlock*)start);
+            size += prev_size;
+            prev_used = TagAt(start) & TAG_PREV_USED;
+        }
+
+        MakeFree(start, size, prev_used);
+
+        m_used_memory -= block_size;
+        m_num_allocations--;
+        StatsFreed();
+        PublishFreeBlocks();
+    }
+
+    void Reset() override {
+        m_used_memory = 0;
+        m_num_allocations = 0;
+        StatsFreed();
+        StatsBlocksCleared();
+
+        m_fl_bitmap = 0;
+        for (int fl = 0; fl < FL_COUNT; ++fl) {
+            m_sl_bitmap[fl] = 0;
+            for (int sl = 0; sl < SL_COUNT; ++sl) m_blocks[fl][sl] = nullptr;
+        }
+
+        //last word is a 0-size used block so nothing merges past the end
+        size_t usable = (m_total_size & ~(size_t)7) - sizeof(size_t);
+        TagAt((uintptr_t)m_start_ptr + usable) = 0 | TAG_USED;
+
+        MakeFree((uintptr_t)m_start_ptr, usable, TAG_PREV_USED);
+        PublishFreeBlocks();
+    }
+
+    //owner thread only (use GetSnapshot() from other threads), walks every list
+    size_t GetNumFreeBlocks() const {
+        size_t count = 0;
+        for (int fl = 0; fl < FL_COUNT; ++fl) {
+            for (int sl = 0; sl < SL_COUNT; ++sl) {
+                for (FreeBlock* b = m_blocks[fl][sl]; b != nullptr; b = b->nextFree) count++;
+            }
+        }
+        return count;
+    }
+
+    //owner thread only: the largest block sits in the highest non-empty list
+    size_t GetLargestFreeBlock() const {
+        if (m_fl_bitmap == 0) return 0;
+        int fl = Log2(m_fl_bitmap);
+        int sl = 31 - __builtin_clz(m_sl_bitmap[fl]);
+
+        size_t largest = 0;
+        for (FreeBlock* b = m_blocks[fl][sl]; b != nullptr; b = b->nextFree) {
+            size_t size = b->tag & ~TAG_FLAGS;
+            if (size > largest) largest = size;
+        }
+        return largest;
+    }
+
+private:
+    void PublishFreeBlocks() {
+        StatsPublishFreeBlocks([this] { return GetLargestFreeBlock(); });
+    }
+
+    static size_t& TagAt(uintptr_t block) { return *(size_t*)block; }
+
+    static int Log2(size_t size) { return 63 - __builtin_clzll(size); }
+
+    //list a block of exactly this size belongs to
+    static void Mapping(size_t size, int& fl, int& sl) {
+        if (size < SMALL_BLOCK) {
+            fl = 0;
+            sl = (int)(size / (SMALL_BLOCK / SL_COUNT));
+        } else {
+            int log2 = Log2(size);
+            fl = log2 - FL_SHIFT + 1;
+            sl = (int)(size >> (log2 - SL_LOG2)) ^ SL_COUNT;
+        }
+    }
+
+    //first list whose every block is >= size: round size up to the next list boundary
+    static void MappingSearch(size_t size, int& fl, int& sl) {
+        if (size >= SMALL_BLOCK) {
+            size += ((size_t)1 << (Log2(size) - SL_LOG2)) - 1;
+        } else {
+            size += (SMALL_BLOCK / SL_COUNT) - 1;
+        }
+        Mapping(size, fl, sl);
+    }
+
+    FreeBlock* FindSuitable(size_t size) {
+        int fl, sl;
+        MappingSearch(size, fl, sl);
+        if (fl >= FL_COUNT) return nullptr;
+
+        uint32_t sl_map = m_sl_bitmap[fl] & (~0u << sl);
+        if (sl_map == 0) {
+            uint64_t fl_map = (fl + 1 < 64) ? (m_fl_bitmap & (~0ULL << (fl + 1))) : 0;
+            if (fl_map == 0) return nullptr;
+
+            fl = __builtin_ctzll(fl_map);
+            sl_map = m_sl_bitmap[fl];
+        }
+        sl = __builtin_ctz(sl_map);
+        return m_blocks[fl][sl];
+    }
+
+    void InsertFree(FreeBlock* block) {
+        int fl, sl;
+        Mapping(block->tag & ~TAG_FLAGS, fl, sl);
+
+        block->prevFree = nullptr;
+        block->nextFree = m_blocks[fl][sl];
+        if (block->nextFree) block->nextFree->prevFree = block;
+        m_blocks[fl][sl] = block;
+
+        m_sl_bitmap[fl] |= (1u << sl);
+        m_fl_bitmap |= (1ULL << fl);
+        StatsBlockAdded(block->tag & ~TAG_FLAGS);
+    }
+
+    void RemoveFree(FreeBlock* block) {
+        int fl, sl;
+        Mapping(block->tag & ~TAG_FLAGS, fl, sl);
+
+        if (block->prevFree) block->prevFree->nextFree = block->nextFree;
+        else m_blocks[fl][sl] = block->nextFree;
+        if (block->nextFree) block->nextFree->prevFree = block->prevFree;
+
+        if (m_blocks[fl][sl] == nullptr) {
+            m_sl_bitmap[fl] &= ~(1u << sl);
+            if (m_sl_bitmap[fl] == 0) m_fl_bitmap &= ~(1ULL << fl);
+        }
+        StatsBlockRemoved(block->tag & ~TAG_FLAGS);
+    }
+
+    void MakeFree(uintptr_t start, size_t size, size_t prevUsedFlag) {
+        TagAt(start) = size | prevUsedFlag;
+        *(size_t*)(start + size - sizeof(size_t)) = size;
+        InsertFree((FreeBlock*)start);
+    }
+};
+
+#endif
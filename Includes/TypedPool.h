@@ -0,0 +1,199 @@
+#ifndef TYPED_POOL_H
+#define TYPED_POOL_H
+
+#include "Allocator.h"
+#include "LinearAllocator.h"
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+// Pool of T with everything known at compile time: chunk size and alignment come from
+// T, there is no virtual call and no size argument, so Create/Destroy inline down to a
+// few instructions. Same lazy scheme as PoolAllocator (bump for never used slots, free
+// list for returned ones), but the free list links slot indices instead of pointers,
+// so the pool contents don't depend on where the storage lives.
+//
+//   TypedPool<T, N>  N slots stored inline in the pool object (no heap at all)
+//   TypedPool<T>     capacity given at runtime, slots come from a LinearAllocator with
+//                    the requested backing memory, or from memory the caller owns
+//                    (MemoryFor() bytes). Slots hold no pointers, so such memory can be
+//                    a file that is mapped again later at another address; GetState()
+//                    and SetState() carry the few counters that live outside the slots.
+// With HFT_ALLOCATOR_STATS it keeps the same AllocatorStats as the Allocator classes.
+template <typename T, size_t N = 0>
+class TypedPool {
+private:
+    union Slot {
+        uint32_t nextFree; //index + 1 of the next free slot, 0 ends the list
+        alignas(T) unsigned char object[sizeof(T)];
+    };
+
+    static const uint32_t NONE = 0;
+
+    template <size_t Count, typename Dummy = void>
+    struct Storage {
+        Slot inlineSlots[Count];
+        Storage(size_t, unsigned) {}
+        Slot* Slots() { return inlineSlots; }
+        size_t Capacity() const { return Count; }
+    };
+
+    template <typename Dummy>
+    struct Storage<0, Dummy> {
+        LinearAllocator* memory; //nullptr when the slots belong to the caller
+        Slot* slots;
+        size_t capacity;
+
+        Storage(void* external, size_t count) : memory(nullptr), slots((Slot*)external), capacity(count) {}
+
+        Storage(size_t count, unsigned backing) : capacity(count) {
+            memory = new LinearAllocator(count * sizeof(Slot));
+            memory->SetBackingMemory(backing);
+            memory->Init();
+            slots = (Slot*)memory->Allocate(count * sizeof(Slot), alignof(Slot));
+        }
+        ~Storage() { delete memory; }
+
+        Slot* Slots() { return slots; }
+        size_t Capacity() const { return capacity; }
+    };
+
+    Storage<N> m_storage;
+    uint32_t m_free_head; //index + 1, NONE when empty
+    uint32_t m_bump;      //first never used slot
+    size_t m_live;
+
+#ifdef HFT_ALLOCATOR_STATS
+    AllocatorStats m_stats;
+#endif
+
+public:
+    static constexpr size_t CHUNK_SIZE = sizeof(Slot);
+    static constexpr size_t ALIGNMENT = alignof(Slot);
+
+    struct State {
+        uint32_t freeHead;
+        uint32_t bump;
+        uint64_t live;
+    };
+
+    static constexpr size_t MemoryFor(size_t capacity) { return capacity * sizeof(Slot); }
+
+    explicit TypedPool(size_t capacity = N, unsigned backing = MEM_HEAP)
+        : m_storage(capacity, backing), m_free_head(NONE), m_bump(0), m_live(0)
+#ifdef HFT_ALLOCATOR_STATS
+          , m_stats(capacity * CHUNK_SIZE)
+#endif
+    {
+#ifdef HFT_ALLOCATOR_STATS
+        m_stats.Configure(AllocatorStats::FREE_CHUNKS, CHUNK_SIZE);
+#endif
+    }
+
+    //slots in memory the caller owns (MemoryFor(capacity) bytes, ALIGNMENT aligned), N = 0 only
+    TypedPool(void* memory, size_t capacity)
+        : m_storage(memory, capacity), m_free_head(NONE), m_bump(0), m_live(0)
+#ifdef HFT_ALLOCATOR_STATS
+          , m_stats(capacity * CHUNK_SIZE)
+#endif
+    {
+#ifdef HFT_ALLOCATOR_STATS
+        m_stats.Configure(AllocatorStats::FREE_CHUNKS, CHUNK_SIZE);
+#endif
+    }
+
+    TypedPool(const TypedPool&) = delete;
+    TypedPool& operator=(const TypedPool&) = delete;
+
+    //nullptr when the pool is full
+    template <typename... Args>
+    T* Create(Args&&... args) {
+        Slot* slot;
+        if (m_free_head != NONE) {
+            slot = &m_storage.Slots()[m_free_head - 1];
+            m_free_head = slot->nextFree;
+        } else if (m_bump < m_storage.Capacity()) {
+            slot = &m_storage.Slots()[m_bump++];
+        } else {
+#ifdef HFT_ALLOCATOR_STATS
+            m_stats.OnFailure();
+#endif
+            return nullptr;
+        }
+
+        m_live++;
+#ifdef HFT_ALLOCATOR_STATS
+        m_stats.OnAllocate(sizeof(T), m_live * CHUNK_SIZE, m_live);
+#endif
+        return new (slot->object) T(std::forward<Args>(args)...);
+    }
+
+    void Destroy(T* ptr) {
+        ptr->~T();
+
+        Slot* slot = (Slot*)ptr;
+        slot->nextFree = m_free_head;
+        m_free_head = IndexOf(ptr) + 1;
+        m_live--;
+#ifdef HFT_ALLOCATOR_STATS
+        m_stats.OnDeallocate(m_live * CHUNK_SIZE, m_live);
+#endif
+    }
+
+    //drops every object without running destructors
+    void Reset() {
+        m_free_head = NONE;
+        m_bump = 0;
+        m_live = 0;
+#ifdef HFT_ALLOCATOR_STATS
+        m_stats.Publish(0, 0);
+#endif
+    }
+
+    State GetState() const {
+        State state;
+        state.freeHead = m_free_head;
+        state.bump = m_bump;
+        state.live = m_live;
+        return state;
+    }
+
+    //the slots must hold what they held when state was taken
+    void SetState(const State& state) {
+        m_free_head = state.freeHead;
+        m_bump = state.bump;
+        m_live = (size_t)state.live;
+#ifdef HFT_ALLOCATOR_STATS
+        m_stats.Publish(m_live * CHUNK_SIZE, m_live);
+#endif
+    }
+
+    uint32_t IndexOf(const T* ptr) { return (uint32_t)((const Slot*)ptr - m_storage.Slots()); }
+    T* At(uint32_t index) { return (T*)m_storage.Slots()[index].object; }
+
+    size_t Size() const { return m_live; }
+    size_t Capacity() const { return m_storage.Capacity(); }
+    size_t GetUsedMemory() const { return m_live * CHUNK_SIZE; }
+
+    //same contract as Allocator::GetSnapshot
+    bool GetSnapshot(AllocatorSnapshot& out) const {
+#ifdef HFT_ALLOCATOR_STATS
+        m_stats.Snapshot(out);
+        return true;
+#else
+        out = AllocatorSnapshot();
+        out.totalSize = Capacity() * CHUNK_SIZE;
+        return false;
+#endif
+    }
+
+    void ResetStats() {
+#ifdef HFT_ALLOCATOR_STATS
+        m_stats.Reset();
+        m_stats.Publish(m_live * CHUNK_SIZE, m_live);
+#endif
+    }
+};
+
+#endif
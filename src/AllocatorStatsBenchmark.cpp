@@ -0,0 +1,159 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+#include "../Includes/Allocator.h"
+#include "../Includes/LinearAllocator.h"
+#include "../Includes/StackAllocator.h"
+#include "../Includes/PoolAllocator.h"
+#include "../Includes/FreeListAllocator.h"
+#include "../Includes/TLSFAllocator.h"
+#include "../Includes/BuddyAllocator.h"
+#include "../Includes/TypedPool.h"
+#include "../Includes/OrderBook.h"
+#include "../Includes/FeedFile.h"
+#include "BenchmarkUtils.h"
+
+// Cost and output of the allocator telemetry (AllocatorStats.h). Build it twice, with and
+// without -DHFT_ALLOCATOR_STATS, and compare the ns/op: the first part runs the same
+// random allocate/free mix through every allocator. With a feed file the second part
+// replays it while a monitoring thread polls the order book's pool snapshots every
+// millisecond, and prints what it saw.
+
+const int OPS = 2000000;
+const int REPS = 5;
+
+static std::vector<uint32_t> MakeSizes() {
+    std::mt19937 rng(11);
+    std::vector<uint32_t> sizes(4096);
+    for (size_t i = 0; i < sizes.size(); ++i) sizes[i] = 16 + rng() % 240;
+    return sizes;
+}
+
+// Keeps up to 1024 blocks live: allocate into a random slot, freeing what was there
+template <typename Alloc, typename Free>
+static double Mix(const std::vector<uint32_t>& sizes, Alloc alloc, Free free) {
+    std::vector<void*> live(1024, nullptr);
+    std::mt19937 rng(5);
+
+    Timer timer;
+    timer.Start();
+    for (int i = 0; i < OPS; ++i) {
+        uint32_t r = rng();
+        void*& slot = live[r & 1023];
+        if (slot != nullptr) free(slot);
+        slot = alloc(sizes[(r >> 10) & 4095]);
+    }
+    double ms = timer.Stop();
+
+    for (size_t i = 0; i < live.size(); ++i) {
+        if (live[i] != nullptr) free(live[i]);
+    }
+    return ms * 1e6 / OPS;
+}
+
+static void Report(const char* name, std::vector<double>& times, const AllocatorSnapshot& snap) {
+    std::sort(times.begin(), times.end());
+    std::cout << "  " << name << ": " << times[times.size() / 2] << " ns/op";
+    if (snap.enabled) {
+        std::cout << "  (peak " << snap.peakUsedMemory << " bytes / " << snap.peakAllocations << " blocks, failed "
+                  << snap.failedAllocations << ", free blocks " << snap.numFreeBlocks << ", largest " << snap.largestFreeBlock << ")";
+    }
+    std::cout << std::endl;
+}
+
+template <typename A>
+static void RunAllocator(const char* name, A* allocator, const std::vector<uint32_t>& sizes) {
+    allocator->Init();
+    std::vector<double> times;
+    for (int r = 0; r < REPS; ++r) {
+        times.push_back(Mix(sizes,
+            [allocator](size_t size) { return allocator->Allocate(size, 8); },
+            [allocator](void* ptr) { allocator->Deallocate(ptr); }));
+    }
+    AllocatorSnapshot snap;
+    allocator->GetSnapshot(snap);
+    Report(name, times, snap);
+    delete allocator;
+}
+
+struct Block256 {
+    char bytes[256];
+};
+
+static void RunTypedPool(const std::vector<uint32_t>& sizes) {
+    TypedPool<Block256>* pool = new TypedPool<Block256>(2048);
+    std::vector<double> times;
+    for (int r = 0; r < REPS; ++r) {
+        times.push_back(Mix(sizes,
+            [pool](size_t) { return (void*)pool->Create(); },
+            [pool](void* ptr) { pool->Destroy((Block256*)ptr); }));
+    }
+    AllocatorSnapshot snap;
+    pool->GetSnapshot(snap);
+    Report("TypedPool<256 bytes>", times, snap);
+    delete pool;
+}
+
+static void ReplayWithMonitor(const char* path) {
+    MappedFeed feed;
+    if (!feed.Open(path)) return;
+    const FeedHeader& header = feed.Header();
+    OrderBook* book = new OrderBook(header.midPrice, header.tickSize, header.numLevels, header.maxLive);
+
+    std::atomic<bool> done(false);
+    size_t polls = 0;
+    size_t maxSeen = 0;
+    std::thread monitor([&]() {
+        AllocatorSnapshot orders;
+        while (!done.load(std::memory_order_acquire)) {
+            if (!book->GetOrderPoolSnapshot(orders)) break;
+            polls++;
+            maxSeen = std::max(maxSeen, orders.numAllocations);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    Timer timer;
+    timer.Start();
+    ForEachRecord(feed, [book](const IncomingMessage& msg) { book->ProcessMessage(msg); });
+    double ms = timer.Stop();
+    done.store(true, std::memory_order_release);
+    monitor.join();
+
+    std::cout << "Replay of " << path << " (" << feed.Size() << " messages): " << ms << " ms, monitor polled "
+              << polls << " times, most live orders it saw " << maxSeen << std::endl;
+
+    AllocatorSnapshot snap;
+    book->GetOrderPoolSnapshot(snap);
+    snap.Print("  Order pool");
+    book->GetLevelPoolSnapshot(snap);
+    snap.Print("  Level pool");
+    delete book;
+}
+
+int main(int argc, char** argv) {
+#ifdef HFT_ALLOCATOR_STATS
+    std::cout << "Allocator stats: compiled in" << std::endl;
+#else
+    std::cout << "Allocator stats: compiled out (build with -DHFT_ALLOCATOR_STATS to compare)" << std::endl;
+#endif
+
+    std::vector<uint32_t> sizes = MakeSizes();
+    std::cout << "Random allocate/free mix, " << OPS << " ops, 16-255 bytes, up to 1024 live, median of " << REPS << std::endl;
+
+    RunAllocator("PoolAllocator", new PoolAllocator(2048 * 256, 256), sizes);
+    RunAllocator("FreeListAllocator (first fit)", new FreeListAllocator(1024 * 1024, FreeListAllocator::FIRST_FIT), sizes);
+    RunAllocator("FreeListAllocator (segregated)", new FreeListAllocator(1024 * 1024, FreeListAllocator::SEGREGATED_FIT), sizes);
+    RunAllocator("TLSFAllocator", new TLSFAllocator(1024 * 1024), sizes);
+    RunAllocator("BuddyAllocator", new BuddyAllocator(1024 * 1024), sizes);
+    RunTypedPool(sizes);
+
+    if (argc > 1) ReplayWithMonitor(argv[1]);
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include <iostream>
+#include <string>
+#include <cstdint>
+
+#include "../Includes/LinearAllocator.h"
+#include "BenchmarkUtils.h"
+#include "PerfCounters.h"
+
+// First touch cost and TLB pressure of each backing memory source.
+// For every configuration a LinearAllocator gets a REGION_SIZE region, then:
+//  - Init: time to get the region (prefault and mlock happen here)
+//  - First touch: carve the whole region into OBJECT_SIZE objects and write each one,
+//    the way a book fills up during the day; page faults land here unless prefaulted
+//  - Random reads: RANDOM_READS reads spread over the region, dTLB misses show how
+//    much 2 MB pages help once everything is mapped
+// Counters come from PerfCounters (perf_event_open); when the kernel or VM doesn't
+// allow them the column prints n/a and only times are reported.
+
+const size_t REGION_SIZE = 256 * 1024 * 1024;
+const size_t OBJECT_SIZE = 64;
+const int RANDOM_READS = 5000000;
+
+volatile uint64_t g_sink; //keeps the random reads from being optimised out
+
+static std::string Describe(unsigned flags) {
+    std::string s = (flags & MEM_PAGES) ? "mmap" : "malloc";
+    if (flags & MEM_HUGE_PAGES) s += " + hugetlb";
+    if (flags & MEM_TRANSPARENT_HUGE_PAGES) s += " + THP";
+    if (flags & MEM_PREFAULT) s += " + prefault";
+    if (flags & MEM_LOCK) s += " + mlock";
+    return s;
+}
+
+static void PrintCount(const char* label, double value) {
+    std::cout << label;
+    if (value < 0) std::cout << "n/a";
+    else std::cout << (long long)value;
+}
+
+static void Run(const char* label, unsigned flags) {
+    std::cout << "Testing " << label << "..." << std::endl;
+
+    PerfCounters counters;
+
+    LinearAllocator* linear = new LinearAllocator(REGION_SIZE);
+    linear->SetBackingMemory(flags);
+
+    Timer timer;
+    timer.Start();
+    linear->Init();
+    double initMs = timer.Stop();
+
+    size_t numObjects = REGION_SIZE / OBJECT_SIZE;
+
+    counters.Start();
+    timer.Start();
+    for (size_t i = 0; i < numObjects; ++i) {
+        uint64_t* obj = (uint64_t*)linear->Allocate(OBJECT_SIZE);
+        obj[0] = i;
+    }
+    double touchMs = timer.Stop();
+    counters.Stop();
+    double faults = counters.Get(PerfCounters::PAGE_FAULTS);
+
+    //xorshift so the index math stays cheap next to the miss we want to measure
+    uint64_t state = 88172645463325252ULL;
+    uint64_t sum = 0;
+    char* base = (char*)linear->GetStart();
+
+    counters.Start();
+    timer.Start();
+    for (int i = 0; i < RANDOM_READS; ++i) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        sum += *(uint64_t*)(base + (state % numObjects) * OBJECT_SIZE);
+    }
+    double readMs = timer.Stop();
+    counters.Stop();
+    double misses = counters.Get(PerfCounters::DTLB_MISSES);
+    g_sink = sum;
+
+    std::cout << "  Backing: " << Describe(linear->GetBackingMemory()) << std::endl;
+    std::cout << "  Init " << initMs << " ms, first touch " << touchMs << " ms";
+    PrintCount(" (page faults ", faults);
+    std::cout << "), random reads " << readMs << " ms";
+    PrintCount(" (dTLB misses ", misses);
+    std::cout << ")" << std::endl;
+
+    delete linear;
+}
+
+int main() {
+    std::cout << "Backing memory benchmark" << std::endl;
+    std::cout << "Region: " << REGION_SIZE / (1024 * 1024) << " MB, Object Size: " << OBJECT_SIZE
+              << " bytes, Random reads: " << RANDOM_READS << std::endl;
+
+    Run("malloc", MEM_HEAP);
+    Run("mmap 4K", MEM_PAGES);
+    Run("mmap 4K + prefault", MEM_PAGES | MEM_PREFAULT);
+    Run("huge pages", MEM_HUGE_PAGES);
+    Run("huge pages + prefault", MEM_HUGE_PAGES | MEM_PREFAULT);
+    Run("huge pages + prefault + mlock", MEM_HUGE_PAGES | MEM_PREFAULT | MEM_LOCK);
+
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+
+#include "../Includes/OrderBook.h"
+#include "../Includes/IncomingMessage.h"
+#include "../Includes/FeedFile.h"
+#include "BenchmarkUtils.h"
+#include "PerfCounters.h"
+
+// OrderBook::ProcessBatch against one ProcessMessage call per message, on a feed file
+// replayed straight out of the mapping. Batch sizes 1, 8, 32 and 128 (1 gets no
+// lookahead at all, so it only shows the cost of the extra layer). Each pass starts
+// from a fresh book and must end in the same book state as the plain loop, otherwise
+// the run fails. Median of --reps passes, book construction not timed.
+
+struct BookState {
+    size_t orders;
+    size_t levels;
+    long long bestBid, bestAsk;
+
+    bool operator==(const BookState& o) const {
+        return orders == o.orders && levels == o.levels && bestBid == o.bestBid && bestAsk == o.bestAsk;
+    }
+};
+
+static BookState StateOf(const OrderBook* book) {
+    BookState state;
+    state.orders = book->GetNumOrders();
+    state.levels = book->GetNumLevels();
+    state.bestBid = book->HasBids() ? book->GetBestBid() : -1;
+    state.bestAsk = book->HasAsks() ? book->GetBestAsk() : -1;
+    return state;
+}
+
+// batch == 0: the plain ProcessMessage loop
+static double RunPass(const MappedFeed& feed, size_t batch, PerfCounters& counters, BookState& state) {
+    const FeedHeader& header = feed.Header();
+    const IncomingMessage* records = feed.Records();
+    const size_t n = feed.Size();
+    OrderBook* book = new OrderBook(header.midPrice, header.tickSize, header.numLevels, header.maxLive);
+
+    Timer timer;
+    counters.Start();
+    timer.Start();
+    if (batch == 0) {
+        for (size_t i = 0; i < n; ++i) book->ProcessMessage(records[i]);
+    } else {
+        for (size_t i = 0; i < n; i += batch) book->ProcessBatch(records + i, std::min(batch, n - i));
+    }
+    double ms = timer.Stop();
+    counters.Stop();
+
+    state = StateOf(book);
+    delete book;
+    return ms;
+}
+
+int main(int argc, char** argv) {
+    const char* path = nullptr;
+    int reps = 5;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--reps" && i + 1 < argc) reps = std::max(1, atoi(argv[++i]));
+        else if (path == nullptr && arg[0] != '-') path = argv[i];
+        else {
+            path = nullptr;
+            break;
+        }
+    }
+    if (path == nullptr) {
+        std::cout << "Usage: " << argv[0] << " feed.bin [--reps n]" << std::endl;
+        return 1;
+    }
+
+    MappedFeed feed;
+    if (!feed.Open(path)) return 1;
+    const size_t n = feed.Size();
+
+    std::cout << "Batch benchmark: " << path << ", " << n << " messages, median of " << reps
+              << ", lookahead " << OrderBook::BATCH_INDEX_AHEAD << "/" << OrderBook::BATCH_ORDER_AHEAD << " messages" << std::endl;
+
+    PerfCounters counters;
+    BookState reference;
+    RunPass(feed, 0, counters, reference); //warmup, also pulls the file into the page cache
+
+    const size_t batches[5] = { 0, 1, 8, 32, 128 };
+    bool identical = true;
+
+    for (int b = 0; b < 5; ++b) {
+        std::vector<double> times;
+        double cacheMisses = 0;
+        for (int r = 0; r < reps; ++r) {
+            BookState state;
+            times.push_back(RunPass(feed, batches[b], counters, state));
+            double v = counters.Get(PerfCounters::L1D_MISSES);
+            cacheMisses = (v < 0 || cacheMisses < 0) ? -1 : cacheMisses + v;
+            if (!(state == reference)) identical = false;
+        }
+
+        std::sort(times.begin(), times.end());
+        double median = times[times.size() / 2];
+        if (batches[b] == 0) std::cout << "  ProcessMessage loop: ";
+        else std::cout << "  ProcessBatch, " << batches[b] << " per call: ";
+        std::cout << median << " ms, " << (double)n / (median * 1000.0) << " M msgs/s, "
+                  << median * 1e6 / (double)n << " ns/msg, L1d misses/msg ";
+        if (cacheMisses < 0) std::cout << "n/a";
+        else std::cout << cacheMisses / ((double)n * reps);
+        std::cout << std::endl;
+    }
+
+    if (!identical) {
+        std::cout << "[ERROR] batched replay ended in a different book state" << std::endl;
+        return 1;
+    }
+    std::cout << "Every batch size ended in the same book state as the plain loop" << std::endl;
+    return 0;
+}
@@ -0,0 +1,617 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <cstdlib>
+#include <cstring>
+
+#include "../Includes/LinearAllocator.h"
+#include "../Includes/StackAllocator.h"
+#include "../Includes/PoolAllocator.h"
+#include "../Includes/FreeListAllocator.h"
+#include "../Includes/TLSFAllocator.h"
+#include "../Includes/BuddyAllocator.h"
+#include "../Includes/MagazinePoolAllocator.h"
+#include "../Includes/LockFreePoolAllocator.h"
+#include "../Includes/SPSCRing.h"
+#include "../Includes/LatencyHistogram.h"
+#include "../Includes/OrderBook.h"
+#include "BenchmarkUtils.h"
+#include "PerfCounters.h"
+
+// Allocator benchmark suite: the numbers we pick an allocator per subsystem with.
+//
+// Every single threaded workload is generated once as a trace of alloc/free ops (slot,
+// size) and replayed unchanged on every allocator that can run it:
+//   fifo         allocate BULK objects, free them in allocation order
+//   lifo         allocate BULK objects, free them in reverse order
+//   random_free  allocate BULK objects, free them in random order
+//   interleaved  keep ~LIVE objects, then random alloc/free of random victims
+//   orderbook    Order sized objects: resting orders, recent ones cancelled often,
+//                the oldest ones filled (FIFO), new ones arriving all the time
+// sizes: 16, 64, 256, 1024 bytes and mixed (16..1024, log-uniform).
+// Stack only runs LIFO traces, Linear never frees (its Reset() runs between
+// repetitions) and Pool serves every size from chunks of the largest size in the trace.
+//
+// producer_consumer runs on two threads: one allocates and passes the pointer through
+// an SPSC ring, the other frees it. Only thread-safe allocators take part.
+//
+// Each case: one warmup pass, REPS timed passes (ns/op = wall time / ops, median and
+// min are reported) and one probed pass where every call is timed with the TSC into a
+// log-linear histogram (percentiles include the cost of the TSC reads). Hardware
+// counters (PerfCounters) are collected over the timed passes and printed per op under
+// each row when the machine exposes them.
+//
+// Usage: BenchmarkSuite [--csv file] [--json file] [--reps n] [--filter text]
+
+const int BULK = 20000;
+const int LIVE = 5000;
+const int INTERLEAVED_OPS = 200000;
+const int ORDERBOOK_RESTING = 20000;
+const int ORDERBOOK_OPS = 200000;
+const int HANDOFF_OPS = 1000000;
+const size_t HANDOFF_SIZE = 64;
+const size_t MIN_MIXED = 16;
+const size_t MAX_MIXED = 1024;
+
+struct Op {
+    uint32_t slot;
+    uint32_t size; //0 = free the slot
+};
+
+struct Trace {
+    std::string workload;
+    std::string sizeLabel;
+    std::vector<Op> ops;
+    size_t slots;
+    size_t maxSize;
+    size_t peakBytes;
+    size_t totalBytes;
+    bool lifo; //every free releases the most recent live allocation
+};
+
+struct Result {
+    std::string workload;
+    std::string sizeLabel;
+    std::string allocator;
+    size_t ops;
+    double nsPerOpMedian;
+    double nsPerOpMin;
+    double allocNs[4]; //p50, p99, p99.9, max
+    double freeNs[4];
+    double counters[PerfCounters::NUM_EVENTS]; //per op, -1 = not available
+};
+
+// malloc/free behind the same interface, so it pays the same virtual call. malloc
+// aligns to 16, which covers every alignment the workloads ask for.
+class MallocAllocator : public Allocator {
+public:
+    MallocAllocator() : Allocator(0) {}
+    void* Allocate(size_t size, size_t = 8) override { return malloc(size); }
+    void Deallocate(void* ptr) override { free(ptr); }
+    void Init() override {}
+};
+
+enum AllocatorKind { MALLOC_FREE, LINEAR, STACK, POOL, FREELIST_FIRST, FREELIST_SEG, TLSF, BUDDY, NUM_KINDS };
+
+static const char* KIND_NAMES[NUM_KINDS] = {
+    "malloc/free", "Linear", "Stack", "Pool", "FreeList first", "FreeList seg", "TLSF", "Buddy"
+};
+
+static bool CanRun(AllocatorKind kind, const Trace& trace) {
+    if (kind == STACK) return trace.lifo;
+    return true;
+}
+
+static Allocator* Create(AllocatorKind kind, const Trace& trace) {
+    //room for headers and fragmentation; Buddy rounds every block up to a power of two
+    size_t region = 16 * 1024 * 1024 + trace.peakBytes * 8;
+    switch (kind) {
+    case MALLOC_FREE: return new MallocAllocator();
+    case LINEAR: return new LinearAllocator(trace.totalBytes + trace.ops.size() * 16 + 1024 * 1024);
+    case STACK: return new StackAllocator(region);
+    case POOL: return new PoolAllocator(trace.slots * (trace.maxSize + 16) + 1024 * 1024, trace.maxSize);
+    case FREELIST_FIRST: return new FreeListAllocator(region, FreeListAllocator::FIRST_FIT);
+    case FREELIST_SEG: return new FreeListAllocator(region, FreeListAllocator::SEGREGATED_FIT);
+    case TLSF: return new TLSFAllocator(region);
+    case BUDDY: return new BuddyAllocator(region);
+    default: return nullptr;
+    }
+}
+
+//------------------------------------------------------------------------------------
+// Trace generation
+
+static size_t PickSize(std::mt19937& rng, size_t fixedSize) {
+    if (fixedSize != 0) return fixedSize;
+    //log-uniform over [MIN_MIXED, MAX_MIXED]
+    int minLog = __builtin_ctzll(MIN_MIXED), maxLog = __builtin_ctzll(MAX_MIXED);
+    int shift = minLog + (int)(rng() % (maxLog - minLog));
+    size_t base = (size_t)1 << shift;
+    return base + rng() % base;
+}
+
+// Tracks live slots while a trace is built, so peak and totals come out right
+struct TraceBuilder {
+    Trace trace;
+    std::vector<uint32_t> freeSlots;
+    std::vector<uint32_t> slotSize;
+    size_t liveBytes;
+
+    TraceBuilder(const char* workload, const std::string& sizeLabel) : liveBytes(0) {
+        trace.workload = workload;
+        trace.sizeLabel = sizeLabel;
+        trace.slots = 0;
+        trace.maxSize = 0;
+        trace.peakBytes = 0;
+        trace.totalBytes = 0;
+        trace.lifo = false;
+    }
+
+    uint32_t Alloc(size_t size) {
+        uint32_t slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            slot = (uint32_t)trace.slots++;
+            slotSize.push_back(0);
+        }
+        slotSize[slot] = (uint32_t)size;
+        trace.ops.push_back(Op{ slot, (uint32_t)size });
+
+        liveBytes += size;
+        trace.totalBytes += size;
+        if (liveBytes > trace.peakBytes) trace.peakBytes = liveBytes;
+        if (size > trace.maxSize) trace.maxSize = size;
+        return slot;
+    }
+
+    void Free(uint32_t slot) {
+        trace.ops.push_back(Op{ slot, 0 });
+        liveBytes -= slotSize[slot];
+        freeSlots.push_back(slot);
+    }
+};
+
+static Trace BuildBulk(const char* workload, size_t fixedSize, const std::string& sizeLabel, int order) {
+    std::mt19937 rng(1);
+    TraceBuilder b(workload, sizeLabel);
+
+    std::vector<uint32_t> slots;
+    for (int i = 0; i < BULK; ++i) slots.push_back(b.Alloc(PickSize(rng, fixedSize)));
+
+    if (order == 1) std::reverse(slots.begin(), slots.end());
+    if (order == 2) std::shuffle(slots.begin(), slots.end(), rng);
+    for (size_t i = 0; i < slots.size(); ++i) b.Free(slots[i]);
+
+    b.trace.lifo = (order == 1);
+    return b.trace;
+}
+
+static Trace BuildInterleaved(size_t fixedSize, const std::string& sizeLabel) {
+    std::mt19937 rng(2);
+    TraceBuilder b("interleaved", sizeLabel);
+
+    std::vector<uint32_t> live;
+    for (int i = 0; i < LIVE; ++i) live.push_back(b.Alloc(PickSize(rng, fixedSize)));
+
+    for (int i = 0; i < INTERLEAVED_OPS; ++i) {
+        //random walk around LIVE objects
+        bool alloc = live.empty() || (rng() % 2 == 0 && live.size() < (size_t)LIVE * 2);
+        if (alloc) {
+            live.push_back(b.Alloc(PickSize(rng, fixedSize)));
+        } else {
+            size_t victim = rng() % live.size();
+            b.Free(live[victim]);
+            live[victim] = live.back();
+            live.pop_back();
+        }
+    }
+
+    std::shuffle(live.begin(), live.end(), rng);
+    for (size_t i = 0; i < live.size(); ++i) b.Free(live[i]);
+    return b.trace;
+}
+
+// Resting orders are kept in arrival order. Most cancels hit recent orders (quotes being
+// pulled and replaced), fills take the oldest ones at the front of the queue.
+static Trace BuildOrderBook() {
+    std::mt19937 rng(3);
+    TraceBuilder b("orderbook", "order");
+    const size_t size = sizeof(Order);
+
+    std::vector<uint32_t> resting; //oldest first
+    for (int i = 0; i < ORDERBOOK_RESTING; ++i) resting.push_back(b.Alloc(size));
+
+    size_t front = 0;
+    for (int i = 0; i < ORDERBOOK_OPS; ++i) {
+        size_t live = resting.size() - front;
+        unsigned roll = rng() % 100;
+
+        if (live > 0 && roll < 35) {
+            //cancel one of the 256 newest
+            size_t window = live < 256 ? live : 256;
+            size_t idx = resting.size() - 1 - rng() % window;
+            b.Free(resting[idx]);
+            resting.erase(resting.begin() + idx);
+        } else if (live > 0 && roll < 50) {
+            b.Free(resting[front++]);
+        } else {
+            resting.push_back(b.Alloc(size));
+        }
+
+        //drop the consumed front now and then so the vector doesn't keep growing
+        if (front > 4096) {
+            resting.erase(resting.begin(), resting.begin() + front);
+            front = 0;
+        }
+    }
+
+    for (size_t i = front; i < resting.size(); ++i) b.Free(resting[i]);
+    return b.trace;
+}
+
+//------------------------------------------------------------------------------------
+// Replay
+
+// false if the allocator ran out of memory
+template <bool PROBE>
+static bool Replay(Allocator* allocator, const Trace& trace, std::vector<void*>& ptrs,
+                   LatencyHistogram* allocLatency, LatencyHistogram* freeLatency) {
+    const Op* ops = trace.ops.data();
+    size_t count = trace.ops.size();
+
+    for (size_t i = 0; i < count; ++i) {
+        const Op& op = ops[i];
+        if (op.size != 0) {
+            uint64_t t0 = PROBE ? ReadTsc() : 0;
+            void* p = allocator->Allocate(op.size);
+            if (PROBE) allocLatency->Record(ReadTsc() - t0);
+
+            if (p == nullptr) return false;
+            *(char*)p = 1; //touch it like a real user would
+            ptrs[op.slot] = p;
+        } else {
+            uint64_t t0 = PROBE ? ReadTsc() : 0;
+            allocator->Deallocate(ptrs[op.slot]);
+            if (PROBE) freeLatency->Record(ReadTsc() - t0);
+        }
+    }
+    return true;
+}
+
+static void FillPercentiles(const LatencyHistogram& h, double out[4]) {
+    double ticksPerNano = TscTicksPerNano();
+    out[0] = h.Percentile(50) / ticksPerNano;
+    out[1] = h.Percentile(99) / ticksPerNano;
+    out[2] = h.Percentile(99.9) / ticksPerNano;
+    out[3] = h.Max() / ticksPerNano;
+}
+
+static void Summarise(std::vector<double>& nsPerOp, Result& result) {
+    std::sort(nsPerOp.begin(), nsPerOp.end());
+    result.nsPerOpMedian = nsPerOp[nsPerOp.size() / 2];
+    result.nsPerOpMin = nsPerOp[0];
+}
+
+static void FillCounters(const PerfCounters& counters, double ops, Result& result) {
+    for (int e = 0; e < PerfCounters::NUM_EVENTS; ++e) {
+        result.counters[e] = counters.PerOp((PerfCounters::Event)e, ops);
+    }
+}
+
+static bool RunTrace(AllocatorKind kind, const Trace& trace, int reps, PerfCounters& counters, Result& result) {
+    Allocator* allocator = Create(kind, trace);
+    allocator->Init();
+
+    std::vector<void*> ptrs(trace.slots);
+    std::vector<double> nsPerOp;
+    bool ok = Replay<false>(allocator, trace, ptrs, nullptr, nullptr); //warmup
+    allocator->Reset();
+
+    //counters cover every timed pass, Reset() included
+    counters.Start();
+    for (int rep = 0; rep < reps && ok; ++rep) {
+        Timer timer;
+        timer.Start();
+        ok = Replay<false>(allocator, trace, ptrs, nullptr, nullptr);
+        double ms = timer.Stop();
+        allocator->Reset();
+
+        nsPerOp.push_back(ms * 1e6 / (double)trace.ops.size());
+    }
+    counters.Stop();
+
+    LatencyHistogram allocLatency;
+    LatencyHistogram freeLatency;
+    if (ok) {
+        ok = Replay<true>(allocator, trace, ptrs, &allocLatency, &freeLatency);
+        allocator->Reset();
+    }
+    delete allocator;
+
+    if (!ok) return false;
+
+    result.workload = trace.workload;
+    result.sizeLabel = trace.sizeLabel;
+    result.allocator = KIND_NAMES[kind];
+    result.ops = trace.ops.size();
+    Summarise(nsPerOp, result);
+    FillPercentiles(allocLatency, result.allocNs);
+    FillPercentiles(freeLatency, result.freeNs);
+    FillCounters(counters, (double)trace.ops.size() * reps, result);
+    return true;
+}
+
+//------------------------------------------------------------------------------------
+// Producer/consumer
+
+typedef SPSCRing<void*, 1024> HandoffRing;
+
+//single threaded pool behind one lock, the baseline for the concurrent pools
+class MutexPoolAllocator : public Allocator {
+    PoolAllocator pool;
+    std::mutex lock;
+public:
+    MutexPoolAllocator(size_t totalSize, size_t chunkSize) : Allocator(totalSize), pool(totalSize, chunkSize) {}
+    void Init() override { pool.Init(); }
+    void* Allocate(size_t size, size_t alignment = 8) override {
+        std::lock_guard<std::mutex> guard(lock);
+        return pool.Allocate(size, alignment);
+    }
+    void Deallocate(void* ptr) override {
+        std::lock_guard<std::mutex> guard(lock);
+        pool.Deallocate(ptr);
+    }
+};
+
+template <bool PROBE>
+static double Handoff(Allocator* allocator, LatencyHistogram* allocLatency, LatencyHistogram* freeLatency) {
+    HandoffRing* ring = new HandoffRing();
+
+    std::thread consumer([&]() {
+        int freed = 0;
+        while (freed < HANDOFF_OPS) {
+            size_t n = ring->ConsumeBatch([&](void* const& p) {
+                uint64_t t0 = PROBE ? ReadTsc() : 0;
+                allocator->Deallocate(p);
+                if (PROBE) freeLatency->Record(ReadTsc() - t0);
+            });
+            if (n == 0) std::this_thread::yield();
+            freed += (int)n;
+        }
+    });
+
+    Timer timer;
+    timer.Start();
+    for (int i = 0; i < HANDOFF_OPS; ++i) {
+        uint64_t t0 = PROBE ? ReadTsc() : 0;
+        void* p = allocator->Allocate(HANDOFF_SIZE);
+        if (PROBE) allocLatency->Record(ReadTsc() - t0);
+
+        *(char*)p = 1;
+        while (!ring->TryPush(p)) std::this_thread::yield();
+    }
+    consumer.join();
+    double ms = timer.Stop();
+
+    delete ring;
+    return ms;
+}
+
+// counters only see the producer (this thread)
+static void RunHandoff(const char* label, int kind, int reps, PerfCounters& counters, std::vector<Result>& results) {
+    //worst case every chunk sits in the ring or a magazine at once
+    size_t region = (size_t)HANDOFF_OPS * HANDOFF_SIZE;
+    std::vector<double> nsPerOp;
+    LatencyHistogram allocLatency;
+    LatencyHistogram freeLatency;
+    double countedOps = 0;
+    double totals[PerfCounters::NUM_EVENTS];
+    for (int e = 0; e < PerfCounters::NUM_EVENTS; ++e) totals[e] = 0;
+
+    for (int rep = 0; rep <= reps + 1; ++rep) {
+        //fresh allocator every pass so nothing stays cached in magazines
+        Allocator* allocator;
+        if (kind == 0) allocator = new MallocAllocator();
+        else if (kind == 1) allocator = new MutexPoolAllocator(region, HANDOFF_SIZE);
+        else if (kind == 2) allocator = new MagazinePoolAllocator(region, HANDOFF_SIZE);
+        else allocator = new LockFreePoolAllocator(region, HANDOFF_SIZE);
+        allocator->Init();
+
+        if (rep == 0) {
+            Handoff<false>(allocator, nullptr, nullptr);
+        } else if (rep <= reps) {
+            counters.Start();
+            double ms = Handoff<false>(allocator, nullptr, nullptr);
+            counters.Stop();
+            nsPerOp.push_back(ms * 1e6 / (2.0 * HANDOFF_OPS));
+
+            //one pass per fresh allocator, so add them up by hand
+            for (int e = 0; e < PerfCounters::NUM_EVENTS; ++e) {
+                double v = counters.Get((PerfCounters::Event)e);
+                totals[e] = (v < 0 || totals[e] < 0) ? -1 : totals[e] + v;
+            }
+            countedOps += (double)HANDOFF_OPS;
+        } else {
+            Handoff<true>(allocator, &allocLatency, &freeLatency);
+        }
+        delete allocator;
+    }
+
+    Result result;
+    result.workload = "producer_consumer";
+    result.sizeLabel = std::to_string(HANDOFF_SIZE);
+    result.allocator = label;
+    result.ops = 2 * (size_t)HANDOFF_OPS;
+    Summarise(nsPerOp, result);
+    FillPercentiles(allocLatency, result.allocNs);
+    FillPercentiles(freeLatency, result.freeNs);
+    for (int e = 0; e < PerfCounters::NUM_EVENTS; ++e) {
+        result.counters[e] = totals[e] < 0 ? -1 : totals[e] / countedOps;
+    }
+    results.push_back(result);
+}
+
+//------------------------------------------------------------------------------------
+// Output
+
+static void PrintHeader() {
+    std::cout << std::left << std::setw(18) << "workload" << std::setw(7) << "size" << std::setw(16) << "allocator"
+              << std::right << std::setw(9) << "ns/op" << std::setw(9) << "min"
+              << " | alloc p50    p99  p99.9      max | free p50    p99  p99.9      max" << std::endl;
+}
+
+static void PrintRow(const Result& r) {
+    std::cout << std::left << std::setw(18) << r.workload << std::setw(7) << r.sizeLabel << std::setw(16) << r.allocator
+              << std::right << std::fixed << std::setprecision(1)
+              << std::setw(9) << r.nsPerOpMedian << std::setw(9) << r.nsPerOpMin << std::setprecision(0)
+              << " |  " << std::setw(8) << r.allocNs[0] << std::setw(7) << r.allocNs[1] << std::setw(7) << r.allocNs[2] << std::setw(9) << r.allocNs[3]
+              << " | " << std::setw(8) << r.freeNs[0] << std::setw(7) << r.freeNs[1] << std::setw(7) << r.freeNs[2] << std::setw(9) << r.freeNs[3]
+              << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+    std::cout << std::setprecision(6);
+}
+
+static void PrintCounters(const Result& r) {
+    std::cout << "    counters/op:" << std::fixed << std::setprecision(2);
+    for (int e = 0; e < PerfCounters::NUM_EVENTS; ++e) {
+        std::cout << "  " << PerfCounters::Name((PerfCounters::Event)e) << " ";
+        if (r.counters[e] < 0) std::cout << "n/a";
+        else std::cout << r.counters[e];
+    }
+    std::cout << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+    std::cout << std::setprecision(6);
+}
+
+static void WriteCsv(const std::string& path, const std::vector<Result>& results) {
+    std::ofstream out(path);
+    out << "workload,size,allocator,ops,ns_per_op_median,ns_per_op_min,"
+        << "alloc_p50_ns,alloc_p99_ns,alloc_p999_ns,alloc_max_ns,free_p50_ns,free_p99_ns,free_p999_ns,free_max_ns,"
+        << "cycles,instructions,l1d_misses,llc_misses,dtlb_misses,branch_misses,page_faults\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << r.workload << ',' << r.sizeLabel << ',' << r.allocator << ',' << r.ops << ','
+            << r.nsPerOpMedian << ',' << r.nsPerOpMin;
+        for (int k = 0; k < 4; ++k) out << ',' << r.allocNs[k];
+        for (int k = 0; k < 4; ++k) out << ',' << r.freeNs[k];
+        //per op, empty when the counter is not available
+        for (int e = 0; e < PerfCounters::NUM_EVENTS; ++e) {
+            out << ',';
+            if (r.counters[e] >= 0) out << r.counters[e];
+        }
+        out << '\n';
+    }
+}
+
+static void WriteJson(const std::string& path, const std::vector<Result>& results) {
+    static const char* PCT[4] = { "p50", "p99", "p999", "max" };
+    static const char* EVENTS[PerfCounters::NUM_EVENTS] = {
+        "cycles", "instructions", "l1d_misses", "llc_misses", "dtlb_misses", "branch_misses", "page_faults"
+    };
+    std::ofstream out(path);
+    out << "[\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << "  {\"workload\": \"" << r.workload << "\", \"size\": \"" << r.sizeLabel
+            << "\", \"allocator\": \"" << r.allocator << "\", \"ops\": " << r.ops
+            << ", \"ns_per_op_median\": " << r.nsPerOpMedian << ", \"ns_per_op_min\": " << r.nsPerOpMin;
+        out << ", \"alloc_ns\": {";
+        for (int k = 0; k < 4; ++k) out << (k ? ", " : "") << '"' << PCT[k] << "\": " << r.allocNs[k];
+        out << "}, \"free_ns\": {";
+        for (int k = 0; k < 4; ++k) out << (k ? ", " : "") << '"' << PCT[k] << "\": " << r.freeNs[k];
+        out << "}, \"counters_per_op\": {";
+        for (int e = 0; e < PerfCounters::NUM_EVENTS; ++e) {
+            out << (e ? ", " : "") << '"' << EVENTS[e] << "\": ";
+            if (r.counters[e] >= 0) out << r.counters[e];
+            else out << "null";
+        }
+        out << "}}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+}
+
+int main(int argc, char** argv) {
+    std::string csvPath, jsonPath, filter;
+    int reps = 5;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--csv" && i + 1 < argc) csvPath = argv[++i];
+        else if (arg == "--json" && i + 1 < argc) jsonPath = argv[++i];
+        else if (arg == "--reps" && i + 1 < argc) reps = std::max(1, atoi(argv[++i]));
+        else if (arg == "--filter" && i + 1 < argc) filter = argv[++i];
+        else {
+            std::cout << "Usage: " << argv[0] << " [--csv file] [--json file] [--reps n] [--filter text]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "Allocator benchmark suite" << std::endl;
+    std::cout << "Repetitions: " << reps << " (+1 warmup), TSC ticks/ns: " << TscTicksPerNano() << std::endl;
+
+    std::vector<Trace> traces;
+    size_t fixedSizes[] = { 16, 64, 256, 1024, 0 };
+    for (int s = 0; s < 5; ++s) {
+        std::string label = fixedSizes[s] ? std::to_string(fixedSizes[s]) : "mixed";
+        traces.push_back(BuildBulk("fifo", fixedSizes[s], label, 0));
+        traces.push_back(BuildBulk("lifo", fixedSizes[s], label, 1));
+        traces.push_back(BuildBulk("random_free", fixedSizes[s], label, 2));
+        traces.push_back(BuildInterleaved(fixedSizes[s], label));
+    }
+    traces.push_back(BuildOrderBook());
+
+    PerfCounters counters;
+    bool showCounters = counters.AnyHardware();
+    if (!showCounters) std::cout << "Hardware counters not available, only page faults are collected" << std::endl;
+
+    std::vector<Result> results;
+    PrintHeader();
+
+    for (size_t t = 0; t < traces.size(); ++t) {
+        const Trace& trace = traces[t];
+        if (!filter.empty() && trace.workload.find(filter) == std::string::npos) continue;
+
+        for (int k = 0; k < NUM_KINDS; ++k) {
+            AllocatorKind kind = (AllocatorKind)k;
+            if (!CanRun(kind, trace)) continue;
+
+            Result result;
+            if (!RunTrace(kind, trace, reps, counters, result)) {
+                std::cout << trace.workload << " " << trace.sizeLabel << " " << KIND_NAMES[kind] << ": out of memory, skipped" << std::endl;
+                continue;
+            }
+            PrintRow(result);
+            if (showCounters) PrintCounters(result);
+            results.push_back(result);
+        }
+    }
+
+    if (filter.empty() || std::string("producer_consumer").find(filter) != std::string::npos) {
+        const char* labels[4] = { "malloc/free", "Pool + mutex", "MagazinePool", "LockFreePool" };
+        for (int k = 0; k < 4; ++k) {
+            RunHandoff(labels[k], k, reps, counters, results);
+            PrintRow(results.back());
+            if (showCounters) PrintCounters(results.back());
+        }
+    }
+
+    if (!csvPath.empty()) {
+        WriteCsv(csvPath, results);
+        std::cout << "CSV written to " << csvPath << std::endl;
+    }
+    if (!jsonPath.empty()) {
+        WriteJson(jsonPath, results);
+        std::cout << "JSON written to " << jsonPath << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,59 @@
+#ifndef BENCHMARK_UTILS_H
+#define BENCHMARK_UTILS_H
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+class Timer {
+    std::chrono::high_resolution_clock::time_point start;
+public:
+    void Start() { start = std::chrono::high_resolution_clock::now(); }
+    double Stop() {
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> elapsed = end - start;
+        return elapsed.count();
+    }
+};
+
+inline uint64_t NowNanos() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Per-op samples collected during a run, sorted once at the end.
+// Reserve up front so recording never reallocates inside the timed loop.
+class LatencyRecorder {
+    std::vector<uint64_t> samples;
+    bool sorted;
+public:
+    LatencyRecorder(size_t expected) : sorted(false) { samples.reserve(expected); }
+
+    void Record(uint64_t ns) { samples.push_back(ns); sorted = false; }
+    size_t Count() const { return samples.size(); }
+    void Clear() { samples.clear(); sorted = false; }
+
+    uint64_t Percentile(double p) {
+        if (samples.empty()) return 0;
+        if (!sorted) {
+            std::sort(samples.begin(), samples.end());
+            sorted = true;
+        }
+        size_t idx = (size_t)(p / 100.0 * (double)(samples.size() - 1) + 0.5);
+        return samples[idx];
+    }
+
+    uint64_t Max() { return Percentile(100.0); }
+
+    void Print(const char* label) {
+        std::cout << label << " latency (ns): p50 " << Percentile(50)
+                  << "  p90 " << Percentile(90)
+                  << "  p99 " << Percentile(99)
+                  << "  p99.9 " << Percentile(99.9)
+                  << "  max " << Max() << std::endl;
+    }
+};
+
+#endif
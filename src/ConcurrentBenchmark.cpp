@@ -0,0 +1,271 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <random>
+#include <cstdint>
+#include <mutex>
+
+#include "../Includes/PoolAllocator.h"
+#include "../Includes/MagazinePoolAllocator.h"
+#include "../Includes/LockFreePoolAllocator.h"
+#include "../Includes/SPSCRing.h"
+#include "BenchmarkUtils.h"
+
+// Contention benchmark for the thread-safe pools against new/delete and a plain
+// PoolAllocator behind a mutex, 1..16 threads.
+//  - Local churn: every thread allocates a burst and frees it in random order.
+//  - Hand-off: thread pairs, one side allocates and passes the pointer through an SPSC
+//    ring, the other side frees it (gateway allocates, matcher frees).
+//  - Fan-out: one producer allocates, every other thread frees (one ring each).
+// Every block is stamped on allocation and checked on free, so a chunk handed out twice
+// shows up as a corruption count instead of a silently wrong number.
+
+const int OPS_PER_THREAD = 1000000; //allocations per thread, each one is freed too
+const int BURST = 128;
+const size_t POOL_SIZE = 256 * 1024 * 1024;
+
+struct Payload {
+    uint64_t owner; //stamped on allocation, checked on free
+    char bytes[40];
+};
+
+typedef SPSCRing<Payload*, 1024> HandoffRing;
+
+std::atomic<long long> g_corrupted(0);
+
+struct NewDelete {
+    void* Allocate() { return new Payload(); }
+    void Deallocate(void* p) { delete (Payload*)p; }
+};
+
+//the baseline for the lock-free pool: the single threaded pool behind one lock
+class MutexPoolAllocator {
+    PoolAllocator pool;
+    std::mutex lock;
+public:
+    MutexPoolAllocator(size_t totalSize, size_t chunkSize, size_t alignment) : pool(totalSize, chunkSize, alignment) {}
+    void Init() { pool.Init(); }
+    void* Allocate(size_t size) {
+        std::lock_guard<std::mutex> guard(lock);
+        return pool.Allocate(size);
+    }
+    void Deallocate(void* p) {
+        std::lock_guard<std::mutex> guard(lock);
+        pool.Deallocate(p);
+    }
+};
+
+template <typename Pool>
+struct PoolOps {
+    Pool* pool;
+    void* Allocate() { return pool->Allocate(sizeof(Payload)); }
+    void Deallocate(void* p) { pool->Deallocate(p); }
+};
+
+// Starts numThreads copies of body(threadIndex) together and returns the wall time.
+template <typename Body>
+double RunThreads(int numThreads, Body body) {
+    std::atomic<int> ready(0);
+    std::atomic<bool> go(false);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < numThreads; ++t) {
+        threads.push_back(std::thread([&, t]() {
+            ready.fetch_add(1);
+            while (!go.load()) std::this_thread::yield();
+            body(t);
+        }));
+    }
+
+    while (ready.load() < numThreads) std::this_thread::yield();
+
+    Timer timer;
+    timer.Start();
+    go.store(true);
+    for (size_t i = 0; i < threads.size(); ++i) threads[i].join();
+    return timer.Stop();
+}
+
+template <typename Ops>
+double LocalChurn(Ops ops, int numThreads) {
+    return RunThreads(numThreads, [&](int t) {
+        std::mt19937 rng(t + 1);
+        Payload* live[BURST];
+
+        for (int done = 0; done < OPS_PER_THREAD; done += BURST) {
+            for (int i = 0; i < BURST; ++i) {
+                live[i] = (Payload*)ops.Allocate();
+                live[i]->owner = ((uint64_t)t << 32) | (uint64_t)i;
+            }
+
+            //random free order
+            for (int i = BURST - 1; i > 0; --i) {
+                int j = (int)(rng() % (i + 1));
+                Payload* tmp = live[i]; live[i] = live[j]; live[j] = tmp;
+            }
+
+            for (int i = 0; i < BURST; ++i) {
+                if ((live[i]->owner >> 32) != (uint64_t)t) g_corrupted.fetch_add(1);
+                ops.Deallocate(live[i]);
+            }
+        }
+    });
+}
+
+template <typename Ops>
+double Handoff(Ops ops, int numThreads) {
+    int pairs = numThreads / 2;
+    std::vector<HandoffRing*> rings;
+    for (int i = 0; i < pairs; ++i) rings.push_back(new HandoffRing());
+
+    double ms = RunThreads(pairs * 2, [&](int t) {
+        HandoffRing* ring = rings[t / 2];
+
+        if (t % 2 == 0) {
+            //producer: allocate and pass along
+            for (int i = 0; i < OPS_PER_THREAD; ++i) {
+                Payload* p = (Payload*)ops.Allocate();
+                p->owner = (uint64_t)i;
+                while (!ring->TryPush(p)) std::this_thread::yield();
+            }
+        } else {
+            //consumer: free what the other thread allocated
+            int expected = 0;
+            while (expected < OPS_PER_THREAD) {
+                size_t n = ring->ConsumeBatch([&](Payload* const& p) {
+                    if (p->owner != (uint64_t)expected) g_corrupted.fetch_add(1);
+                    expected++;
+                    ops.Deallocate(p);
+                });
+                if (n == 0) std::this_thread::yield();
+            }
+        }
+    });
+
+    for (int i = 0; i < pairs; ++i) delete rings[i];
+    return ms;
+}
+
+template <typename Ops>
+double FanOut(Ops ops, int numThreads) {
+    int consumers = numThreads - 1;
+    std::vector<HandoffRing*> rings;
+    for (int i = 0; i < consumers; ++i) rings.push_back(new HandoffRing());
+
+    int perConsumer = OPS_PER_THREAD / consumers;
+
+    double ms = RunThreads(numThreads, [&](int t) {
+        if (t == 0) {
+            for (int i = 0; i < perConsumer * consumers; ++i) {
+                Payload* p = (Payload*)ops.Allocate();
+                p->owner = (uint64_t)(i / consumers);
+                HandoffRing* ring = rings[i % consumers];
+                while (!ring->TryPush(p)) std::this_thread::yield();
+            }
+        } else {
+            HandoffRing* ring = rings[t - 1];
+            int expected = 0;
+            while (expected < perConsumer) {
+                size_t n = ring->ConsumeBatch([&](Payload* const& p) {
+                    if (p->owner != (uint64_t)expected) g_corrupted.fetch_add(1);
+                    expected++;
+                    ops.Deallocate(p);
+                });
+                if (n == 0) std::this_thread::yield();
+            }
+        }
+    });
+
+    for (int i = 0; i < consumers; ++i) delete rings[i];
+    return ms;
+}
+
+static void Report(const char* label, int numThreads, int activeThreads, double ms) {
+    double opsTotal = 2.0 * OPS_PER_THREAD * activeThreads; //alloc + free
+    std::cout << "  " << label << " threads " << numThreads << ": " << ms << " ms, "
+              << (opsTotal / ms / 1000.0) << " Mops/sec" << std::endl;
+}
+
+// A fixed size pool must refuse what a chunk can't hold instead of handing out a chunk
+// the caller would overrun into its neighbours. Counted as corruption when it doesn't.
+template <typename Pool>
+static void CheckOversized(Pool* pool, const char* label) {
+    size_t before = pool->GetNumAllocations();
+    void* big = pool->Allocate(sizeof(Payload) * 64, alignof(Payload));
+    void* aligned = pool->Allocate(sizeof(Payload), 4096);
+    if (big != nullptr || aligned != nullptr || pool->GetNumAllocations() != before) {
+        std::cout << "  " << label << " handed out a chunk for an oversized request" << std::endl;
+        g_corrupted.fetch_add(1);
+    }
+}
+
+// Runs one scenario for every allocator. Each pool is created fresh so earlier runs
+// don't leave chunks cached in magazines.
+template <typename Scenario>
+void RunAll(Scenario scenario, int numThreads, int activeThreads) {
+    Report("new/delete     ", numThreads, activeThreads, scenario(NewDelete(), numThreads));
+
+    {
+        MutexPoolAllocator* pool = new MutexPoolAllocator(POOL_SIZE, sizeof(Payload), alignof(Payload));
+        pool->Init();
+        PoolOps<MutexPoolAllocator> ops = { pool };
+        Report("Pool + mutex   ", numThreads, activeThreads, scenario(ops, numThreads));
+        delete pool;
+    }
+    {
+        MagazinePoolAllocator* pool = new MagazinePoolAllocator(POOL_SIZE, sizeof(Payload), alignof(Payload));
+        pool->Init();
+        PoolOps<MagazinePoolAllocator> ops = { pool };
+        Report("MagazinePool   ", numThreads, activeThreads, scenario(ops, numThreads));
+        delete pool;
+    }
+    {
+        LockFreePoolAllocator* pool = new LockFreePoolAllocator(POOL_SIZE, sizeof(Payload), alignof(Payload));
+        pool->Init();
+        CheckOversized(pool, "LockFreePool");
+        PoolOps<LockFreePoolAllocator> ops = { pool };
+        Report("LockFreePool   ", numThreads, activeThreads, scenario(ops, numThreads));
+        if (pool->GetNumAllocations() != 0) {
+            std::cout << "  LockFreePool leaked " << pool->GetNumAllocations() << " chunks" << std::endl;
+            g_corrupted.fetch_add(1);
+        }
+        delete pool;
+    }
+}
+
+struct LocalChurnScenario {
+    template <typename Ops> double operator()(Ops ops, int n) const { return LocalChurn(ops, n); }
+};
+struct HandoffScenario {
+    template <typename Ops> double operator()(Ops ops, int n) const { return Handoff(ops, n); }
+};
+struct FanOutScenario {
+    template <typename Ops> double operator()(Ops ops, int n) const { return FanOut(ops, n); }
+};
+
+int main() {
+    std::cout << "Concurrent allocator benchmark" << std::endl;
+    std::cout << "Allocations per thread: " << OPS_PER_THREAD << ", Object Size: " << sizeof(Payload)
+              << " bytes, Hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+
+    int threadCounts[] = { 1, 2, 4, 8, 16 };
+
+    std::cout << "Local churn (burst of " << BURST << ", random free order)" << std::endl;
+    for (int i = 0; i < 5; ++i) {
+        RunAll(LocalChurnScenario(), threadCounts[i], threadCounts[i]);
+    }
+
+    std::cout << "Cross-thread hand-off (producer allocates, consumer frees)" << std::endl;
+    for (int i = 1; i < 5; ++i) {
+        RunAll(HandoffScenario(), threadCounts[i], threadCounts[i] / 2);
+    }
+
+    std::cout << "Fan-out (one producer allocates, every other thread frees)" << std::endl;
+    for (int i = 1; i < 5; ++i) {
+        RunAll(FanOutScenario(), threadCounts[i], 1);
+    }
+
+    std::cout << "Corrupted blocks: " << g_corrupted.load() << std::endl;
+    return g_corrupted.load() == 0 ? 0 : 1;
+}
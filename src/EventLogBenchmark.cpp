@@ -0,0 +1,119 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#include "../Includes/OrderBook.h"
+#include "../Includes/EventLog.h"
+#include "../Includes/FeedFile.h"
+#include "../Includes/LatencyHistogram.h"
+#include "BenchmarkUtils.h"
+
+// Cost of execution logging on the matching thread: a feed replayed with no event log,
+// then with the asynchronous EventLog under both full-ring policies. The text goes to
+// /dev/null unless --out is given, so the disk is not what is measured.
+// Per mode: one timed pass (the clock stops when the last message is matched, the
+// writer draining afterwards is reported separately) and one pass with every message
+// timed into a histogram.
+
+enum Mode { OFF, ASYNC_DROP, ASYNC_BLOCK, NUM_MODES };
+const char* MODE_NAMES[NUM_MODES] = { "off", "async, drop when full", "async, block when full" };
+
+struct Pass {
+    double ms;
+    double drainMs;
+    uint64_t written;
+    uint64_t dropped;
+};
+
+static Pass RunPass(const MappedFeed& feed, Mode mode, const char* outPath, LatencyHistogram* histogram) {
+    Pass pass = { 0, 0, 0, 0 };
+
+    FILE* out = nullptr;
+    EventLog* log = nullptr;
+    if (mode != OFF) {
+        out = fopen(outPath, "w");
+        if (out == nullptr) {
+            std::cout << "cannot open " << outPath << std::endl;
+            exit(1);
+        }
+        log = new EventLog(out, mode == ASYNC_BLOCK ? EventLog::BLOCK : EventLog::DROP);
+    }
+
+    const FeedHeader& header = feed.Header();
+    OrderBook* book = new OrderBook(header.midPrice, header.tickSize, header.numLevels, header.maxLive);
+    book->SetEventLog(log);
+
+    Timer timer;
+    timer.Start();
+    if (histogram == nullptr) {
+        ForEachRecord(feed, [book](const IncomingMessage& msg) { book->ProcessMessage(msg); });
+    } else {
+        ForEachRecord(feed, [book, histogram](const IncomingMessage& msg) {
+            uint64_t t0 = ReadTsc();
+            book->ProcessMessage(msg);
+            histogram->Record(ReadTsc() - t0);
+        });
+    }
+    pass.ms = timer.Stop();
+
+    if (log != nullptr) {
+        timer.Start();
+        log->Stop();
+        pass.drainMs = timer.Stop();
+        pass.written = log->GetWritten();
+        pass.dropped = log->GetDropped();
+        delete log;
+        fclose(out);
+    }
+    delete book;
+    return pass;
+}
+
+int main(int argc, char** argv) {
+    const char* path = nullptr;
+    const char* outPath = "/dev/null";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--out" && i + 1 < argc) outPath = argv[++i];
+        else if (path == nullptr && arg[0] != '-') path = argv[i];
+        else {
+            path = nullptr;
+            break;
+        }
+    }
+    if (path == nullptr) {
+        std::cout << "Usage: " << argv[0] << " feed.bin [--out file]" << std::endl;
+        return 1;
+    }
+
+    MappedFeed feed;
+    if (!feed.Open(path)) return 1;
+    const size_t n = feed.Size();
+
+    std::cout << "Event log benchmark: " << path << ", " << n << " messages, text to " << outPath
+              << ", ring of " << EventLog::RING_SIZE << " events" << std::endl;
+
+    RunPass(feed, OFF, outPath, nullptr); //warmup
+
+    for (int m = 0; m < NUM_MODES; ++m) {
+        Mode mode = (Mode)m;
+        Pass pass = RunPass(feed, mode, outPath, nullptr);
+
+        std::cout << "Logging " << MODE_NAMES[m] << ": " << pass.ms << " ms, " << (double)n / (pass.ms * 1000.0) << " M msgs/s";
+        if (mode != OFF) {
+            std::cout << ", " << pass.written << " events written, " << pass.dropped << " dropped, writer drained "
+                      << pass.drainMs << " ms later";
+        }
+        std::cout << std::endl;
+
+        LatencyHistogram histogram;
+        RunPass(feed, mode, outPath, &histogram);
+        histogram.Print("  Per message");
+    }
+
+    return 0;
+}
@@ -0,0 +1,258 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+#include "../Includes/IncomingMessage.h"
+#include "../Includes/FeedFile.h"
+
+// Seeded synthetic feed for one symbol, written as a feed file for FeedReplay.
+//  - The mid does a random walk in ticks, clamped to the middle half of the book's band.
+//  - Passive orders land a geometric distance behind the mid (mean --depth ticks), so the
+//    book is thick at the touch and thin far out. The first --prefill messages are only
+//    passive orders to start from a deep book.
+//  - Aggressive orders cross the mid by a few ticks and are bigger.
+//  - Cancels and modifies pick a random order the generator placed earlier. It does not
+//    run a book, so some of them hit orders that already filled (like a real cancel race).
+//  - Bursts: now and then the mid runs one way for a while and most new orders turn
+//    aggressive, a sweep through several levels.
+// Only mt19937's raw output is used (no std distributions), so a seed gives the same file
+// with every compiler.
+
+struct GeneratorConfig {
+    const char* out = "feed.bin";
+    char symbol[4] = { 'A', 'B', 'C', 0 };
+    uint64_t messages = 1000000;
+    uint32_t seed = 1;
+    double midPrice = 100.0;
+    double tickSize = 0.01;
+    uint32_t numLevels = 20000;
+    uint32_t maxLive = 100000;
+    double depth = 20;           //mean distance of passive orders from the mid, ticks
+    uint64_t prefill = 20000;
+    int cancelPct = 40;
+    int modifyPct = 10;          //the rest are new orders
+    int aggressivePct = 10;      //of new orders
+    int burstPer10k = 5;         //chance of a burst starting, per 10000 messages
+    int burstLength = 500;
+};
+
+struct LiveOrder {
+    int id;
+    char side;
+    long long tick;
+    int qty;
+};
+
+class FeedGenerator {
+private:
+    GeneratorConfig cfg;
+    std::mt19937 rng;
+    std::vector<LiveOrder> live;
+
+    long long startTick;
+    long long midOffset; //mid, in ticks from startTick
+    long long maxOffset;
+    int nextId;
+
+    int burstLeft;
+    int burstDirection;
+
+public:
+    uint64_t numNew, numAggressive, numCancel, numModify, numBursts;
+
+    FeedGenerator(const GeneratorConfig& config)
+        : cfg(config), rng(config.seed), midOffset(0), nextId(1), burstLeft(0), burstDirection(1),
+          numNew(0), numAggressive(0), numCancel(0), numModify(0), numBursts(0) {
+        startTick = std::llround(cfg.midPrice / cfg.tickSize);
+        maxOffset = cfg.numLevels / 4;
+        live.reserve(cfg.maxLive);
+    }
+
+    void Next(IncomingMessage& msg, bool prefill) {
+        std::memcpy(msg.symbol, cfg.symbol, 4);
+
+        if (prefill) {
+            NewOrder(msg, false);
+            return;
+        }
+
+        MoveMid();
+
+        int aggressivePct = cfg.aggressivePct;
+        if (burstLeft > 0) {
+            burstLeft--;
+            aggressivePct = 60;
+        }
+
+        int r = (int)(rng() % 100);
+        if (live.size() >= cfg.maxLive || (!live.empty() && r < cfg.cancelPct)) {
+            Cancel(msg);
+        } else if (!live.empty() && r < cfg.cancelPct + cfg.modifyPct) {
+            Modify(msg);
+        } else {
+            NewOrder(msg, (int)(rng() % 100) < aggressivePct);
+        }
+    }
+
+    double MidPrice() const { return (double)(startTick + midOffset) * cfg.tickSize; }
+
+private:
+    void MoveMid() {
+        if (burstLeft == 0 && (int)(rng() % 10000) < cfg.burstPer10k) {
+            burstLeft = cfg.burstLength;
+            burstDirection = (rng() % 2) ? 1 : -1;
+            numBursts++;
+        }
+
+        if (burstLeft > 0) {
+            if (rng() % 8 == 0) midOffset += burstDirection;
+        } else if (rng() % 64 == 0) {
+            midOffset += (rng() % 2) ? 1 : -1;
+        }
+
+        if (midOffset > maxOffset) midOffset = maxOffset;
+        if (midOffset < -maxOffset) midOffset = -maxOffset;
+    }
+
+    //1 + geometric distance with the configured mean, capped inside the band
+    long long PassiveDistance() {
+        double u = ((double)rng() + 1.0) / 4294967296.0;
+        long long dist = 1 + (long long)(-std::log(u) * cfg.depth);
+        return std::min(dist, (long long)maxOffset);
+    }
+
+    void NewOrder(IncomingMessage& msg, bool aggressive) {
+        char side = (rng() % 2) ? 'B' : 'S';
+        long long mid = startTick + midOffset;
+        long long tick;
+        int qty;
+
+        if (aggressive) {
+            long long through = 1 + (long long)(rng() % 5);
+            tick = (side == 'B') ? mid + through : mid - through;
+            qty = 1 + (int)(rng() % 300);
+            numAggressive++;
+        } else {
+            long long dist = PassiveDistance();
+            tick = (side == 'B') ? mid - dist : mid + dist;
+            qty = 1 + (int)(rng() % 100);
+        }
+
+        msg.type = 'N';
+        msg.orderId = nextId++;
+        msg.side = side;
+        msg.price = tick;
+        msg.qty = qty;
+        numNew++;
+
+        LiveOrder order = { msg.orderId, side, tick, qty };
+        live.push_back(order);
+    }
+
+    void Cancel(IncomingMessage& msg) {
+        size_t i = rng() % live.size();
+
+        msg.type = 'C';
+        msg.orderId = live[i].id;
+        msg.side = live[i].side;
+        msg.price = 0;
+        msg.qty = 0;
+        numCancel++;
+
+        live[i] = live.back();
+        live.pop_back();
+    }
+
+    //half reduce the quantity in place, half move the order 1-3 ticks further from the mid
+    void Modify(IncomingMessage& msg) {
+        LiveOrder& order = live[rng() % live.size()];
+
+        if (rng() % 2 && order.qty > 1) {
+            order.qty /= 2;
+        } else {
+            long long move = 1 + (long long)(rng() % 3);
+            order.tick += (order.side == 'B') ? -move : move;
+        }
+
+        msg.type = 'M';
+        msg.orderId = order.id;
+        msg.side = order.side;
+        msg.price = order.tick;
+        msg.qty = order.qty;
+        numModify++;
+    }
+};
+
+static void Usage(const char* program) {
+    std::cout << "Usage: " << program << " [--out file] [--messages n] [--seed n] [--symbol XYZ] [--mid price] [--tick size]\n"
+              << "       [--levels n] [--max-live n] [--depth ticks] [--prefill n] [--cancel pct] [--modify pct]\n"
+              << "       [--aggressive pct] [--bursts per10k] [--burst-length n]" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    GeneratorConfig cfg;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            Usage(argv[0]);
+            return 1;
+        }
+        const char* value = argv[++i];
+
+        if (arg == "--out") cfg.out = value;
+        else if (arg == "--messages") cfg.messages = strtoull(value, nullptr, 10);
+        else if (arg == "--seed") cfg.seed = (uint32_t)strtoul(value, nullptr, 10);
+        else if (arg == "--symbol") {
+            std::memset(cfg.symbol, 0, 4);
+            std::memcpy(cfg.symbol, value, std::min(std::strlen(value), (size_t)4));
+        }
+        else if (arg == "--mid") cfg.midPrice = atof(value);
+        else if (arg == "--tick") cfg.tickSize = atof(value);
+        else if (arg == "--levels") cfg.numLevels = (uint32_t)atoi(value);
+        else if (arg == "--max-live") cfg.maxLive = (uint32_t)atoi(value);
+        else if (arg == "--depth") cfg.depth = atof(value);
+        else if (arg == "--prefill") cfg.prefill = strtoull(value, nullptr, 10);
+        else if (arg == "--cancel") cfg.cancelPct = atoi(value);
+        else if (arg == "--modify") cfg.modifyPct = atoi(value);
+        else if (arg == "--aggressive") cfg.aggressivePct = atoi(value);
+        else if (arg == "--bursts") cfg.burstPer10k = atoi(value);
+        else if (arg == "--burst-length") cfg.burstLength = atoi(value);
+        else {
+            Usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (cfg.maxLive == 0 || cfg.numLevels < 64 || cfg.tickSize <= 0 || cfg.cancelPct + cfg.modifyPct > 100) {
+        std::cout << "invalid configuration" << std::endl;
+        return 1;
+    }
+
+    std::vector<IncomingMessage> records(cfg.messages);
+    FeedGenerator generator(cfg);
+    for (uint64_t i = 0; i < cfg.messages; ++i) {
+        generator.Next(records[i], i < cfg.prefill);
+    }
+
+    FeedHeader header;
+    InitFeedHeader(header);
+    header.numLevels = cfg.numLevels;
+    header.maxLive = cfg.maxLive;
+    header.seed = cfg.seed;
+    header.midPrice = cfg.midPrice;
+    header.tickSize = cfg.tickSize;
+
+    if (!WriteFeed(cfg.out, header, records)) return 1;
+
+    std::cout << "Wrote " << cfg.messages << " messages to " << cfg.out << " (seed " << cfg.seed << ")" << std::endl;
+    std::cout << "  new " << generator.numNew << " (aggressive " << generator.numAggressive << "), cancel " << generator.numCancel
+              << ", modify " << generator.numModify << ", bursts " << generator.numBursts << std::endl;
+    std::cout << "  mid " << cfg.midPrice << " -> " << generator.MidPrice() << std::endl;
+    return 0;
+}
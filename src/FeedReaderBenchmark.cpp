@@ -0,0 +1,202 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+#include "../Includes/OrderBook.h"
+#include "../Includes/IncomingMessage.h"
+#include "../Includes/FeedFile.h"
+#include "../Includes/LinearAllocator.h"
+#include "BenchmarkUtils.h"
+
+// How fast a feed file gets from disk into the matcher, three ways:
+//  - read(): the file copied into a LinearAllocator buffer in 1 MB read() calls, then replayed
+//  - mmap: MappedFeed, records used in place, plain loop
+//  - mmap + prefetch: the same through ForEachRecord (cache line prefetch + MADV_WILLNEED)
+// Each pass times everything from open to the last message (book construction included,
+// the same for all three). Two consumers: a scan that only folds the fields into a
+// checksum (so the I/O path is most of the cost) and the order book itself. "cold" passes evict the file from the page cache first
+// (posix_fadvise DONTNEED), "warm" ones find it there.
+
+const size_t READ_CHUNK = 1024 * 1024;
+
+static void EvictFromPageCache(const char* path) {
+#ifdef __linux__
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return;
+    fdatasync(fd); //dirty pages can't be dropped
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+#else
+    (void)path;
+#endif
+}
+
+struct ScanConsumer {
+    long long checksum = 0;
+    void Begin(const FeedHeader&) {}
+    void operator()(const IncomingMessage& msg) { checksum += msg.orderId + msg.qty + msg.type; }
+    void End() {}
+};
+
+struct BookConsumer {
+    OrderBook* book = nullptr;
+    long long checksum = 0;
+    void Begin(const FeedHeader& header) {
+        book = new OrderBook(header.midPrice, header.tickSize, header.numLevels, header.maxLive);
+    }
+    void operator()(const IncomingMessage& msg) { book->ProcessMessage(msg); }
+    void End() {
+        checksum += (long long)book->GetNumOrders();
+        delete book;
+        book = nullptr;
+    }
+};
+
+// read() path: one region for the whole file, filled with plain reads
+template <typename Consumer>
+static bool ReplayRead(const char* path, Consumer& consumer) {
+#ifdef __linux__
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+
+    size_t fileSize = (size_t)st.st_size;
+    LinearAllocator* buffer = new LinearAllocator(fileSize + 64); //room for the alignment
+    buffer->Init();
+    char* data = (char*)buffer->Allocate(fileSize, 64);
+
+    size_t done = 0;
+    while (done < fileSize) {
+        ssize_t got = read(fd, data + done, std::min(READ_CHUNK, fileSize - done));
+        if (got <= 0) break;
+        done += (size_t)got;
+    }
+    close(fd);
+
+    FeedHeader header;
+    std::memcpy(&header, data, std::min(sizeof(header), done));
+    if (done != fileSize || !CheckFeedHeader(header, fileSize, path)) {
+        delete buffer;
+        return false;
+    }
+
+    IncomingMessage* records = (IncomingMessage*)(data + FeedDataOffset(header));
+    if (header.version < 3) ConvertFeedRecords(header, records, records);
+    consumer.Begin(header);
+    for (size_t i = 0; i < header.numRecords; ++i) consumer(records[i]);
+    consumer.End();
+
+    delete buffer;
+    return true;
+#else
+    FeedHeader header;
+    std::vector<IncomingMessage> records;
+    if (!ReadFeed(path, header, records)) return false;
+    consumer.Begin(header);
+    for (size_t i = 0; i < records.size(); ++i) consumer(records[i]);
+    consumer.End();
+    return true;
+#endif
+}
+
+template <typename Consumer>
+static bool ReplayMapped(const char* path, Consumer& consumer, bool prefetch) {
+    MappedFeed feed;
+    if (!feed.Open(path)) return false;
+
+    consumer.Begin(feed.Header());
+    if (prefetch) {
+        ForEachRecord(feed, [&consumer](const IncomingMessage& msg) { consumer(msg); });
+    } else {
+        const IncomingMessage* records = feed.Records();
+        for (size_t i = 0; i < feed.Size(); ++i) consumer(records[i]);
+    }
+    consumer.End();
+    return true;
+}
+
+// mode: 0 read(), 1 mmap, 2 mmap + prefetch
+template <typename Consumer>
+static void Run(const char* label, const char* path, size_t numRecords, int mode, bool cold, int reps) {
+    std::vector<double> times;
+    long long checksum = 0;
+
+    for (int r = 0; r < reps; ++r) {
+        if (cold) EvictFromPageCache(path);
+
+        Consumer consumer;
+        Timer timer;
+        timer.Start();
+        bool ok = (mode == 0) ? ReplayRead(path, consumer) : ReplayMapped(path, consumer, mode == 2);
+        double ms = timer.Stop();
+        if (!ok) {
+            std::cout << "  " << label << ": failed" << std::endl;
+            return;
+        }
+        times.push_back(ms);
+        checksum = consumer.checksum;
+    }
+
+    std::sort(times.begin(), times.end());
+    double median = times[times.size() / 2];
+    std::cout << "  " << label << ": " << median << " ms, " << (double)numRecords / (median * 1000.0)
+              << " M msgs/s (checksum " << checksum << ")" << std::endl;
+}
+
+template <typename Consumer>
+static void RunAll(const char* path, size_t numRecords, int reps) {
+    const char* modes[3] = { "read()", "mmap", "mmap + prefetch" };
+    for (int cold = 1; cold >= 0; --cold) {
+        for (int mode = 0; mode < 3; ++mode) {
+            std::string label = std::string(modes[mode]) + (cold ? ", cold" : ", warm");
+            Run<Consumer>(label.c_str(), path, numRecords, mode, cold == 1, reps);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    const char* path = nullptr;
+    int reps = 5;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--reps" && i + 1 < argc) reps = std::max(1, atoi(argv[++i]));
+        else if (path == nullptr && arg[0] != '-') path = argv[i];
+        else {
+            path = nullptr;
+            break;
+        }
+    }
+    if (path == nullptr) {
+        std::cout << "Usage: " << argv[0] << " feed.bin [--reps n]" << std::endl;
+        return 1;
+    }
+
+    MappedFeed feed;
+    if (!feed.Open(path)) return 1;
+    size_t numRecords = feed.Size();
+    feed.Close();
+
+    std::cout << "Feed reader benchmark: " << path << ", " << numRecords << " messages, "
+              << numRecords * sizeof(IncomingMessage) / (1024 * 1024) << " MB, median of " << reps << std::endl;
+
+    std::cout << "Scan (checksum only)" << std::endl;
+    RunAll<ScanConsumer>(path, numRecords, reps);
+
+    std::cout << "Order book replay" << std::endl;
+    RunAll<BookConsumer>(path, numRecords, reps);
+
+    return 0;
+}
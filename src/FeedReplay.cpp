@@ -0,0 +1,171 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+
+#include "../Includes/OrderBook.h"
+#include "../Includes/IncomingMessage.h"
+#include "../Includes/FeedFile.h"
+#include "../Includes/LatencyHistogram.h"
+#include "BenchmarkUtils.h"
+#include "PerfCounters.h"
+
+// Replays a feed file (see FeedGenerator.cpp) through OrderBook::ProcessMessage with
+// logging off, straight out of the mapped file (MappedFeed, no copy). Every pass starts
+// from a fresh book built from the feed header.
+//  - warmup pass, its final book state is the reference
+//  - timed passes: throughput and hardware counters; each must end in the same state,
+//    otherwise the replay is not deterministic and the run fails
+//  - one probed pass with every message timed into a histogram, per message type
+// Book construction is never inside the timed region.
+
+struct BookState {
+    size_t orders;
+    size_t levels;
+    bool hasBid, hasAsk;
+    Price bestBid, bestAsk;
+    PriceScale scale;
+
+    bool operator==(const BookState& o) const {
+        return orders == o.orders && levels == o.levels && hasBid == o.hasBid && hasAsk == o.hasAsk &&
+               (!hasBid || bestBid == o.bestBid) && (!hasAsk || bestAsk == o.bestAsk);
+    }
+};
+
+static OrderBook* NewBook(const FeedHeader& header) {
+    OrderBook* book = new OrderBook(header.midPrice, header.tickSize, header.numLevels, header.maxLive);
+    return book;
+}
+
+static BookState StateOf(const OrderBook* book) {
+    BookState state;
+    state.orders = book->GetNumOrders();
+    state.levels = book->GetNumLevels();
+    state.hasBid = book->HasBids();
+    state.hasAsk = book->HasAsks();
+    state.bestBid = state.hasBid ? book->GetBestBid() : 0;
+    state.bestAsk = state.hasAsk ? book->GetBestAsk() : 0;
+    state.scale = book->GetPriceScale();
+    return state;
+}
+
+static void PrintState(const BookState& state) {
+    std::cout << "Final book: " << state.orders << " orders on " << state.levels << " levels, best bid ";
+    if (state.hasBid) std::cout << state.scale.ToDouble(state.bestBid); else std::cout << "-";
+    std::cout << ", best ask ";
+    if (state.hasAsk) std::cout << state.scale.ToDouble(state.bestAsk); else std::cout << "-";
+    std::cout << std::endl;
+}
+
+static int TypeIndex(char type) {
+    return type == 'C' ? 1 : (type == 'M' ? 2 : 0);
+}
+
+int main(int argc, char** argv) {
+    const char* path = nullptr;
+    int reps = 5;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--reps" && i + 1 < argc) reps = std::max(1, atoi(argv[++i]));
+        else if (path == nullptr && arg[0] != '-') path = argv[i];
+        else {
+            path = nullptr;
+            break;
+        }
+    }
+    if (path == nullptr) {
+        std::cout << "Usage: " << argv[0] << " feed.bin [--reps n]" << std::endl;
+        return 1;
+    }
+
+    MappedFeed feed;
+    if (!feed.Open(path)) return 1;
+
+    const FeedHeader& header = feed.Header();
+    const IncomingMessage* messages = feed.Records();
+    const size_t n = feed.Size();
+    uint64_t typeCounts[3] = { 0, 0, 0 };
+    for (size_t i = 0; i < n; ++i) typeCounts[TypeIndex(messages[i].type)]++;
+
+    std::cout << "Order book replay of " << path << std::endl;
+    std::cout << "Messages: " << n << " (new " << typeCounts[0] << ", cancel " << typeCounts[1] << ", modify " << typeCounts[2]
+              << "), seed " << header.seed << ", levels " << header.numLevels << ", max live " << header.maxLive << std::endl;
+    std::cout << "Repetitions: " << reps << " (+1 warmup)" << std::endl;
+    std::cout << "Order record: " << sizeof(Order) << " bytes hot (" << 64 / sizeof(Order) << " per cache line) + "
+              << sizeof(OrderInfo) << " bytes cold" << std::endl;
+
+    BookState reference;
+    {
+        OrderBook* book = NewBook(header);
+        ForEachRecord(feed, [book](const IncomingMessage& msg) { book->ProcessMessage(msg); });
+        reference = StateOf(book);
+        delete book;
+    }
+    PrintState(reference);
+
+    PerfCounters counters;
+    std::vector<double> times;
+    double counterTotals[PerfCounters::NUM_EVENTS] = {};
+    bool deterministic = true;
+
+    for (int r = 0; r < reps; ++r) {
+        OrderBook* book = NewBook(header);
+
+        Timer timer;
+        counters.Start();
+        timer.Start();
+        ForEachRecord(feed, [book](const IncomingMessage& msg) { book->ProcessMessage(msg); });
+        double ms = timer.Stop();
+        counters.Stop();
+
+        times.push_back(ms);
+        for (int e = 0; e < PerfCounters::NUM_EVENTS; ++e) {
+            double v = counters.Get((PerfCounters::Event)e);
+            counterTotals[e] = (v < 0 || counterTotals[e] < 0) ? -1 : counterTotals[e] + v;
+        }
+
+        if (!(StateOf(book) == reference)) deterministic = false;
+        delete book;
+    }
+
+    std::sort(times.begin(), times.end());
+    double median = times[times.size() / 2];
+    std::cout << "Replay: median " << median << " ms, min " << times[0] << " ms, "
+              << (double)n / (median * 1000.0) << " M msgs/s, " << median * 1e6 / (double)n << " ns/msg" << std::endl;
+
+    std::cout << "  Counters per msg:";
+    for (int e = 0; e < PerfCounters::NUM_EVENTS; ++e) {
+        std::cout << "  " << PerfCounters::Name((PerfCounters::Event)e) << " ";
+        if (counterTotals[e] < 0) std::cout << "n/a";
+        else std::cout << counterTotals[e] / ((double)n * reps);
+    }
+    std::cout << std::endl;
+
+    //probed pass: one TSC pair per message, so it is a bit slower than the timed passes
+    {
+        LatencyHistogram all, byType[3];
+        OrderBook* book = NewBook(header);
+        ForEachRecord(feed, [&](const IncomingMessage& msg) {
+            uint64_t t0 = ReadTsc();
+            book->ProcessMessage(msg);
+            uint64_t ticks = ReadTsc() - t0;
+            all.Record(ticks);
+            byType[TypeIndex(msg.type)].Record(ticks);
+        });
+        delete book;
+
+        all.Print("  All");
+        byType[0].Print("  New");
+        byType[1].Print("  Cancel");
+        byType[2].Print("  Modify");
+    }
+
+    if (!deterministic) {
+        std::cout << "[ERROR] replays ended in different book states" << std::endl;
+        return 1;
+    }
+    std::cout << "Deterministic: every pass ended in the same book state" << std::endl;
+    return 0;
+}
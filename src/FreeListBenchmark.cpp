@@ -0,0 +1,121 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include "../Includes/FreeListAllocator.h"
+#include "BenchmarkUtils.h"
+
+// Per call latency of the FreeListAllocator placement policies under fragmentation.
+// Fill the heap with random sized blocks, churn (free a random live block, allocate a
+// new random size), then free everything in random order. The same seeded sequence
+// is replayed for every policy.
+// Second part: benchmark.cpp's pattern (N x 16 byte allocations) but freed in random
+// order, where first fit pays an address-ordered list walk on every free.
+
+const int LIVE_BLOCKS = 20000;
+const int CHURN_OPS = 100000;
+const size_t MIN_SIZE = 16;
+const size_t MAX_SIZE = 512;
+const size_t TOTAL_SIZE = 512 * 1024 * 1024; // 512 MB
+
+const int RANDOM_FREES = 500000;
+const int RANDOM_FREES_FIRST_FIT = 50000; //first fit is O(n) per free, 500k takes minutes
+
+struct Vector4 {
+    float x, y, z, w;
+};
+
+static void Run(const char* label, FreeListAllocator::PlacementPolicy policy) {
+    std::cout << "Testing " << label << "..." << std::endl;
+
+    FreeListAllocator* freeList = new FreeListAllocator(TOTAL_SIZE, policy);
+    freeList->Init();
+
+    std::mt19937 rng(1234);
+    std::vector<void*> live(LIVE_BLOCKS);
+    LatencyRecorder allocLatency(LIVE_BLOCKS + CHURN_OPS);
+    LatencyRecorder freeLatency(LIVE_BLOCKS + CHURN_OPS);
+
+    Timer timer;
+    timer.Start();
+
+    for (int i = 0; i < LIVE_BLOCKS; ++i) {
+        size_t size = MIN_SIZE + rng() % (MAX_SIZE - MIN_SIZE + 1);
+        uint64_t t0 = NowNanos();
+        live[i] = freeList->Allocate(size, 8);
+        allocLatency.Record(NowNanos() - t0);
+    }
+
+    for (int i = 0; i < CHURN_OPS; ++i) {
+        int victim = (int)(rng() % LIVE_BLOCKS);
+        size_t size = MIN_SIZE + rng() % (MAX_SIZE - MIN_SIZE + 1);
+
+        uint64_t t0 = NowNanos();
+        freeList->Deallocate(live[victim]);
+        uint64_t t1 = NowNanos();
+        live[victim] = freeList->Allocate(size, 8);
+        uint64_t t2 = NowNanos();
+
+        freeLatency.Record(t1 - t0);
+        allocLatency.Record(t2 - t1);
+    }
+
+    std::shuffle(live.begin(), live.end(), rng);
+    for (int i = 0; i < LIVE_BLOCKS; ++i) {
+        uint64_t t0 = NowNanos();
+        freeList->Deallocate(live[i]);
+        freeLatency.Record(NowNanos() - t0);
+    }
+
+    std::cout << "Result: " << timer.Stop() << " ms" << std::endl;
+    allocLatency.Print("  Allocate");
+    freeLatency.Print("  Deallocate");
+
+    delete freeList;
+}
+
+static void RunRandomFrees(const char* label, FreeListAllocator::PlacementPolicy policy, int count) {
+    std::cout << "Testing " << label << " (" << count << " random order frees)..." << std::endl;
+
+    FreeListAllocator* freeList = new FreeListAllocator(TOTAL_SIZE, policy);
+    freeList->Init();
+
+    std::vector<void*> ptrs(count);
+    for (int i = 0; i < count; ++i) {
+        ptrs[i] = freeList->Allocate(sizeof(Vector4), alignof(Vector4));
+    }
+
+    std::mt19937 rng(99);
+    std::shuffle(ptrs.begin(), ptrs.end(), rng);
+
+    LatencyRecorder freeLatency(count);
+    Timer timer;
+    timer.Start();
+
+    for (int i = 0; i < count; ++i) {
+        uint64_t t0 = NowNanos();
+        freeList->Deallocate(ptrs[i]);
+        freeLatency.Record(NowNanos() - t0);
+    }
+
+    std::cout << "Result: " << timer.Stop() << " ms" << std::endl;
+    freeLatency.Print("  Deallocate");
+
+    delete freeList;
+}
+
+int main() {
+    std::cout << "Free list benchmark" << std::endl;
+    std::cout << "Live blocks: " << LIVE_BLOCKS << ", Churn ops: " << CHURN_OPS
+              << ", Sizes: " << MIN_SIZE << ".." << MAX_SIZE << " bytes" << std::endl;
+
+    Run("First fit", FreeListAllocator::FIRST_FIT);
+    Run("Segregated fit", FreeListAllocator::SEGREGATED_FIT);
+
+    RunRandomFrees("First fit", FreeListAllocator::FIRST_FIT, RANDOM_FREES_FIRST_FIT);
+    RunRandomFrees("Segregated fit", FreeListAllocator::SEGREGATED_FIT, RANDOM_FREES_FIRST_FIT);
+    RunRandomFrees("Segregated fit", FreeListAllocator::SEGREGATED_FIT, RANDOM_FREES);
+
+    return 0;
+}
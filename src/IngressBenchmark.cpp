@@ -0,0 +1,115 @@
+#include <iostream>
+#include <thread>
+#include <cstring>
+#include <new>
+
+#include "../Includes/LinearAllocator.h"
+#include "../Includes/IncomingMessage.h"
+#include "../Includes/SPSCRing.h"
+#include "BenchmarkUtils.h"
+
+// Compares the old ingress path (one LinearAllocator slot per packet + Reset) with
+// the SPSC ring between a network thread and a matching thread.
+// The matcher side only folds the message into a checksum, so what we measure is
+// the hand-off itself and not the order book.
+
+const int NUM_MESSAGES = 2000000;
+const size_t RING_SIZE = 4096;
+
+struct TimedMessage {
+    IncomingMessage msg;
+    uint64_t sentNs; //stamped by the producer right before Publish()
+};
+
+static void FillMessage(IncomingMessage* msg, int i) {
+    std::memcpy(msg->symbol, "ABC", 4);
+    msg->orderId = i;
+    msg->side = (i & 1) ? 'S' : 'B';
+    msg->price = 10000 + (i & 15);
+    msg->qty = 10;
+}
+
+static long long Consume(const IncomingMessage& msg) {
+    return msg.orderId + msg.qty + msg.price;
+}
+
+int main() {
+    std::cout << "Ingress benchmark" << std::endl;
+    std::cout << "Messages: " << NUM_MESSAGES << std::endl;
+
+    Timer timer;
+
+    {
+        std::cout << "Testing LinearAllocator per packet + Reset (single thread)..." << std::endl;
+        LinearAllocator* msgBuffer = new LinearAllocator(1024 * 1024);
+        msgBuffer->Init();
+
+        LatencyRecorder latency(NUM_MESSAGES);
+        long long checksum = 0;
+
+        timer.Start();
+        for (int i = 0; i < NUM_MESSAGES; ++i) {
+            uint64_t t0 = NowNanos();
+
+            void* pktMem = msgBuffer->Allocate(sizeof(IncomingMessage), alignof(IncomingMessage));
+            IncomingMessage* msg = new (pktMem) IncomingMessage();
+            FillMessage(msg, i);
+            checksum += Consume(*msg);
+            msgBuffer->Reset();
+
+            latency.Record(NowNanos() - t0);
+        }
+        double ms = timer.Stop();
+
+        std::cout << "Result: " << ms << " ms, " << (NUM_MESSAGES / ms * 1000.0) << " msgs/sec (checksum " << checksum << ")" << std::endl;
+        latency.Print("Per packet");
+        delete msgBuffer;
+    }
+
+    {
+        std::cout << "Testing SPSC ring (network thread -> matching thread)..." << std::endl;
+        SPSCRing<TimedMessage, RING_SIZE>* ring = new SPSCRing<TimedMessage, RING_SIZE>();
+
+        LatencyRecorder latency(NUM_MESSAGES);
+        long long checksum = 0;
+        size_t batches = 0;
+
+        timer.Start();
+
+        std::thread producer([ring]() {
+            for (int i = 0; i < NUM_MESSAGES; ++i) {
+                TimedMessage* slot;
+                while ((slot = ring->TryClaim()) == nullptr) {
+                    std::this_thread::yield();
+                }
+                FillMessage(&slot->msg, i);
+                slot->sentNs = NowNanos();
+                ring->Publish();
+            }
+        });
+
+        int received = 0;
+        while (received < NUM_MESSAGES) {
+            size_t n = ring->ConsumeBatch([&](const TimedMessage& m) {
+                checksum += Consume(m.msg);
+                latency.Record(NowNanos() - m.sentNs);
+            });
+
+            if (n == 0) {
+                std::this_thread::yield();
+            } else {
+                received += (int)n;
+                batches++;
+            }
+        }
+        producer.join();
+        double ms = timer.Stop();
+
+        std::cout << "Result: " << ms << " ms, " << (NUM_MESSAGES / ms * 1000.0) << " msgs/sec (checksum " << checksum
+                  << ", avg batch " << ((double)NUM_MESSAGES / batches) << ")" << std::endl;
+        latency.Print("Publish -> consume");
+        delete ring;
+    }
+
+    return 0;
+}
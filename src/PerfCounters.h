@@ -0,0 +1,147 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <iostream>
+#include <iomanip>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+// Hardware counters for the calling thread (user space only) around a benchmark
+// section, through perf_event_open. Every event is opened on its own, so whatever the
+// CPU, kernel, VM or perf_event_paranoid setting refuses is simply reported as n/a and
+// the rest still works; on other platforms everything is n/a.
+// When the PMU has fewer counters than events the kernel time-multiplexes them, the
+// values are scaled by enabled/running time.
+//
+//   PerfCounters counters;
+//   counters.Start();
+//   ... section ...
+//   counters.Stop();
+//   counters.Print("  Pool", numOps);   //per op values
+class PerfCounters {
+public:
+    enum Event { CYCLES, INSTRUCTIONS, L1D_MISSES, LLC_MISSES, DTLB_MISSES, BRANCH_MISSES, PAGE_FAULTS, NUM_EVENTS };
+
+private:
+    int fds[NUM_EVENTS];
+    double values[NUM_EVENTS]; //-1 when not available
+
+public:
+    PerfCounters() {
+        for (int e = 0; e < NUM_EVENTS; ++e) {
+            fds[e] = -1;
+            values[e] = -1;
+        }
+#ifdef __linux__
+        const uint64_t L1D_READ_MISS = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        const uint64_t DTLB_READ_MISS = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+        fds[CYCLES] = Open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        fds[INSTRUCTIONS] = Open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        fds[L1D_MISSES] = Open(PERF_TYPE_HW_CACHE, L1D_READ_MISS);
+        fds[LLC_MISSES] = Open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        fds[DTLB_MISSES] = Open(PERF_TYPE_HW_CACHE, DTLB_READ_MISS);
+        fds[BRANCH_MISSES] = Open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+        fds[PAGE_FAULTS] = Open(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS);
+#endif
+    }
+
+    ~PerfCounters() {
+#ifdef __linux__
+        for (int e = 0; e < NUM_EVENTS; ++e) {
+            if (fds[e] >= 0) close(fds[e]);
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    static const char* Name(Event e) {
+        static const char* NAMES[NUM_EVENTS] = { "cycles", "instructions", "L1d misses", "LLC misses", "dTLB misses", "branch misses", "page faults" };
+        return NAMES[e];
+    }
+
+    bool Available(Event e) const { return fds[e] >= 0; }
+
+    bool AnyHardware() const {
+        for (int e = 0; e < PAGE_FAULTS; ++e) {
+            if (fds[e] >= 0) return true;
+        }
+        return false;
+    }
+
+    void Start() {
+#ifdef __linux__
+        for (int e = 0; e < NUM_EVENTS; ++e) {
+            if (fds[e] < 0) continue;
+            ioctl(fds[e], PERF_EVENT_IOC_RESET, 0);
+            ioctl(fds[e], PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    void Stop() {
+#ifdef __linux__
+        for (int e = 0; e < NUM_EVENTS; ++e) {
+            if (fds[e] >= 0) ioctl(fds[e], PERF_EVENT_IOC_DISABLE, 0);
+        }
+        for (int e = 0; e < NUM_EVENTS; ++e) {
+            values[e] = -1;
+            if (fds[e] < 0) continue;
+
+            uint64_t data[3]; //value, time enabled, time running
+            if (read(fds[e], data, sizeof(data)) != (ssize_t)sizeof(data)) continue;
+            if (data[2] == 0) {
+                values[e] = data[0] == 0 ? 0 : -1;
+            } else {
+                values[e] = (double)data[0] * ((double)data[1] / (double)data[2]);
+            }
+        }
+#endif
+    }
+
+    //total over the last Start/Stop, -1 when not available
+    double Get(Event e) const { return values[e]; }
+
+    //per op value, -1 when not available
+    double PerOp(Event e, double ops) const { return values[e] < 0 ? -1 : values[e] / ops; }
+
+    void Print(const char* label, double ops) const {
+        std::cout << label << " per op:";
+        for (int e = 0; e < NUM_EVENTS; ++e) {
+            std::cout << "  " << Name((Event)e) << " ";
+            if (values[e] < 0) std::cout << "n/a";
+            else std::cout << std::fixed << std::setprecision(3) << values[e] / ops << std::defaultfloat;
+        }
+        if (values[CYCLES] > 0 && values[INSTRUCTIONS] >= 0) {
+            std::cout << "  IPC " << std::fixed << std::setprecision(2) << values[INSTRUCTIONS] / values[CYCLES] << std::defaultfloat;
+        }
+        std::cout << std::setprecision(6) << std::endl;
+    }
+
+private:
+#ifdef __linux__
+    static int Open(uint32_t type, uint64_t config) {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+#endif
+};
+
+#endif
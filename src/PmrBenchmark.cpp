@@ -0,0 +1,182 @@
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+#include <memory_resource>
+
+#include "../Includes/LinearAllocator.h"
+#include "../Includes/StackAllocator.h"
+#include "../Includes/PoolAllocator.h"
+#include "../Includes/FreeListAllocator.h"
+#include "../Includes/PmrAdaptors.h"
+#include "BenchmarkUtils.h"
+
+// Standard containers on top of the custom allocators through the pmr adaptors,
+// against the default (global new/delete) resource and std's own pool resource.
+//  - Fills: a vector of fills built per incoming order (push_back, no reserve), dropped
+//    after the order is done.
+//  - Symbol map: unordered_map filled, looked up, half erased, then dropped.
+// Linear and Stack are Reset() after every round, the way they would be per message.
+
+const int FILL_ROUNDS = 20000;
+const int FILLS_PER_ROUND = 500;
+const int MAP_ROUNDS = 200;
+const int MAP_KEYS = 10000;
+const size_t REGION_SIZE = 64 * 1024 * 1024;
+
+struct Fill {
+    int orderId;
+    int quantity;
+    double price;
+};
+
+template <typename ResetFn>
+void RunFills(const char* label, std::pmr::memory_resource* resource, ResetFn reset) {
+    long long checksum = 0;
+
+    Timer timer;
+    timer.Start();
+
+    for (int round = 0; round < FILL_ROUNDS; ++round) {
+        {
+            std::pmr::vector<Fill> fills(resource);
+            for (int i = 0; i < FILLS_PER_ROUND; ++i) {
+                fills.push_back(Fill{ i, round & 63, 100.0 });
+            }
+            checksum += fills.size();
+        }
+        reset();
+    }
+
+    double ms = timer.Stop();
+    std::cout << "  " << label << ": " << ms << " ms (checksum " << checksum << ")" << std::endl;
+}
+
+template <typename ResetFn>
+void RunSymbolMap(const char* label, std::pmr::memory_resource* resource, ResetFn reset) {
+    long long checksum = 0;
+
+    Timer timer;
+    timer.Start();
+
+    for (int round = 0; round < MAP_ROUNDS; ++round) {
+        {
+            std::pmr::unordered_map<int, int> symbols(resource);
+            for (int i = 0; i < MAP_KEYS; ++i) {
+                symbols[i * 7919] = i;
+            }
+            for (int i = 0; i < MAP_KEYS; ++i) {
+                checksum += symbols.find(i * 7919)->second;
+            }
+            for (int i = 0; i < MAP_KEYS; i += 2) {
+                symbols.erase(i * 7919);
+            }
+            checksum += symbols.size();
+        }
+        reset();
+    }
+
+    double ms = timer.Stop();
+    std::cout << "  " << label << ": " << ms << " ms (checksum " << checksum << ")" << std::endl;
+}
+
+// Runs one workload over every resource, each allocator created fresh
+template <typename Workload>
+void RunAll(Workload workload) {
+    auto noReset = []() {};
+
+    workload("Default (new/delete)", std::pmr::new_delete_resource(), noReset);
+
+    {
+        std::pmr::unsynchronized_pool_resource stdPool;
+        workload("std unsynchronized_pool", &stdPool, noReset);
+    }
+
+    {
+        LinearAllocator* linear = new LinearAllocator(REGION_SIZE);
+        linear->Init();
+        AllocatorResource resource(linear);
+        workload("Linear (reset per round)", &resource, [linear]() { linear->Reset(); });
+        delete linear;
+    }
+
+    {
+        StackAllocator* stack = new StackAllocator(REGION_SIZE);
+        stack->Init();
+        StackResource resource(stack);
+        workload("Stack (reset per round)", &resource, [&resource]() { resource.Reset(); });
+        delete stack;
+    }
+
+    {
+        //map nodes fit a 32 byte chunk, vector buffers and bucket arrays go upstream
+        PoolAllocator* pool = new PoolAllocator(REGION_SIZE, 32, 8);
+        pool->Init();
+        PoolResource resource(pool);
+        workload("Pool (32B) + new/delete", &resource, noReset);
+        delete pool;
+    }
+
+    {
+        FreeListAllocator* freeList = new FreeListAllocator(REGION_SIZE, FreeListAllocator::SEGREGATED_FIT);
+        freeList->Init();
+        AllocatorResource resource(freeList);
+        workload("Free List (segregated)", &resource, noReset);
+        delete freeList;
+    }
+}
+
+struct FillsWorkload {
+    template <typename ResetFn>
+    void operator()(const char* label, std::pmr::memory_resource* r, ResetFn reset) const { RunFills(label, r, reset); }
+};
+struct SymbolMapWorkload {
+    template <typename ResetFn>
+    void operator()(const char* label, std::pmr::memory_resource* r, ResetFn reset) const { RunSymbolMap(label, r, reset); }
+};
+
+int main() {
+    std::cout << "pmr container benchmark" << std::endl;
+
+    std::cout << "Fills vector (" << FILL_ROUNDS << " rounds x " << FILLS_PER_ROUND << " push_back)" << std::endl;
+    RunAll(FillsWorkload());
+
+    {
+        //plain std::vector for reference: the cost of the pmr layer itself
+        long long checksum = 0;
+
+        Timer timer;
+        timer.Start();
+        for (int round = 0; round < FILL_ROUNDS; ++round) {
+            std::vector<Fill> fills;
+            for (int i = 0; i < FILLS_PER_ROUND; ++i) {
+                fills.push_back(Fill{ i, round & 63, 100.0 });
+            }
+            checksum += fills.size();
+        }
+        std::cout << "  std::allocator (no pmr): " << timer.Stop() << " ms (checksum " << checksum << ")" << std::endl;
+    }
+
+    {
+        //same workload through the classic allocator adaptor, no pmr indirection
+        FreeListAllocator* freeList = new FreeListAllocator(REGION_SIZE, FreeListAllocator::SEGREGATED_FIT);
+        freeList->Init();
+        long long checksum = 0;
+
+        Timer timer;
+        timer.Start();
+        for (int round = 0; round < FILL_ROUNDS; ++round) {
+            std::vector<Fill, StlAllocator<Fill> > fills{ StlAllocator<Fill>(freeList) };
+            for (int i = 0; i < FILLS_PER_ROUND; ++i) {
+                fills.push_back(Fill{ i, round & 63, 100.0 });
+            }
+            checksum += fills.size();
+        }
+        std::cout << "  StlAllocator (Free List): " << timer.Stop() << " ms (checksum " << checksum << ")" << std::endl;
+        delete freeList;
+    }
+
+    std::cout << "Symbol map (" << MAP_ROUNDS << " rounds x " << MAP_KEYS << " keys)" << std::endl;
+    RunAll(SymbolMapWorkload());
+
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <cstring>
+#include <cstdio>
+
+#include "../Includes/MatchingEngine.h"
+#include "../Includes/IncomingMessage.h"
+#include "BenchmarkUtils.h"
+
+// Messages/sec of the sharded engine as the number of matching threads grows.
+// The gateway (this thread) replays a pre-generated stream over NUM_SYMBOLS symbols,
+// each one a random walk around its own mid, so every thread count sees the same flow.
+
+const int NUM_MESSAGES = 4000000;
+const int NUM_SYMBOLS = 64;
+const size_t BOOK_LEVELS = 2000;
+const size_t BOOK_ORDERS = 20000;
+
+static void SymbolName(int s, char* out) {
+    char buf[8];
+    std::snprintf(buf, sizeof(buf), "S%03d", s);
+    std::memcpy(out, buf, 4);
+}
+
+int main() {
+    std::cout << "Sharded engine benchmark" << std::endl;
+    std::cout << "Messages: " << NUM_MESSAGES << ", Symbols: " << NUM_SYMBOLS
+              << ", Hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+
+    std::vector<IncomingMessage> stream(NUM_MESSAGES);
+    std::vector<Price> mids(NUM_SYMBOLS, 10000); //100.0 in 0.01 ticks
+    std::mt19937 rng(42);
+
+    for (int i = 0; i < NUM_MESSAGES; ++i) {
+        int s = (int)(rng() % NUM_SYMBOLS);
+        if (rng() % 16 == 0) mids[s] += (rng() % 2) ? 1 : -1;
+
+        IncomingMessage& msg = stream[i];
+        SymbolName(s, msg.symbol);
+        msg.orderId = i;
+        msg.side = (rng() % 2) ? 'B' : 'S';
+        msg.price = mids[s] + ((int)(rng() % 11) - 5); //crosses often, so the books stay shallow
+        msg.qty = 1 + (int)(rng() % 100);
+    }
+
+    int threadCounts[] = { 1, 2, 4, 8, 16 };
+    Timer timer;
+    double baseline = 0;
+
+    for (int t = 0; t < 5; ++t) {
+        int numThreads = threadCounts[t];
+
+        MatchingEngine* engine = new MatchingEngine(numThreads, 1); //core 0 is left to the gateway
+        engine->SetLogging(false);
+        for (int s = 0; s < NUM_SYMBOLS; ++s) {
+            char name[4];
+            SymbolName(s, name);
+            engine->AddSymbol(name, 100.0, 0.01, BOOK_LEVELS, BOOK_ORDERS);
+        }
+        engine->Start();
+
+        timer.Start();
+        for (int i = 0; i < NUM_MESSAGES; ++i) {
+            engine->Route(stream[i]);
+        }
+        engine->Stop();
+        double ms = timer.Stop();
+
+        double rate = NUM_MESSAGES / ms * 1000.0;
+        if (t == 0) baseline = rate;
+
+        std::cout << "Threads: " << numThreads << "  Result: " << ms << " ms, " << rate << " msgs/sec ("
+                  << (rate / baseline) << "x), processed " << engine->GetProcessed() << std::endl;
+        delete engine;
+    }
+
+    return 0;
+}
@@ -0,0 +1,238 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../Includes/OrderBook.h"
+#include "../Includes/IncomingMessage.h"
+#include "BenchmarkUtils.h"
+
+// Getting a book with 1M resting orders back after a restart: replaying the order flow
+// that built it, against mapping a book image (OrderBook::OpenImage) written by
+// Checkpoint(). The flow is 1.2M passive new orders and 200k cancels. Restore is timed
+// with the image in the page cache (warm) and after dropping it (cold, read from disk),
+// both mapping only (pages come in on first touch) and prefaulted (MAP_POPULATE).
+// The restored book must match the replayed one, before and after a continuation of
+// mixed new/cancel/modify messages that trade, otherwise the run fails.
+
+const double MID = 100.0;
+const double TICK = 0.01;
+const size_t LEVELS = 20000;
+const size_t MAX_ORDERS = 1 << 20;
+const int NEW_ORDERS = 1200000;
+const int CONTINUATION = 200000;
+const int REPS = 3;
+
+struct BookState {
+    size_t orders;
+    size_t levels;
+    long long bestBid, bestAsk;
+    uint64_t infoHash; //ids, clients and sequences of a sample of orders
+
+    bool operator==(const BookState& o) const {
+        return orders == o.orders && levels == o.levels && bestBid == o.bestBid && bestAsk == o.bestAsk && infoHash == o.infoHash;
+    }
+};
+
+static BookState StateOf(const OrderBook* book, int maxId) {
+    BookState state;
+    state.orders = book->GetNumOrders();
+    state.levels = book->GetNumLevels();
+    state.bestBid = book->HasBids() ? book->GetBestBid() : -1;
+    state.bestAsk = book->HasAsks() ? book->GetBestAsk() : -1;
+    state.infoHash = 0;
+    for (int id = 0; id < maxId; id += 97) {
+        const OrderInfo* info = book->GetOrderInfo(id);
+        uint64_t v = info ? ((uint64_t)info->clientId << 40) ^ info->sequence ^ ((uint64_t)info->type << 63) : 1;
+        state.infoHash = state.infoHash * 1000003 + v;
+    }
+    return state;
+}
+
+// Passive only, bids below the mid and asks above, so nothing trades and every new
+// order rests. Every 6th new order cancels one placed 3 messages earlier.
+static std::vector<IncomingMessage> MakeFlow(Price midTick) {
+    std::mt19937 rng(25);
+    std::vector<IncomingMessage> flow;
+    flow.reserve(NEW_ORDERS + NEW_ORDERS / 6);
+
+    for (int i = 0; i < NEW_ORDERS; ++i) {
+        IncomingMessage msg = {};
+        msg.orderId = i;
+        msg.type = 'N';
+        msg.side = (rng() & 1) ? 'B' : 'S';
+        Price away = 1 + (Price)(rng() % 2000);
+        msg.price = msg.side == 'B' ? midTick - away : midTick + away;
+        msg.qty = 1 + rng() % 100;
+        msg.clientId = (int)(rng() % 500);
+        flow.push_back(msg);
+
+        if (i % 6 == 5) {
+            IncomingMessage cancel = {};
+            cancel.orderId = i - 3;
+            cancel.type = 'C';
+            flow.push_back(cancel);
+        }
+    }
+    return flow;
+}
+
+// Orders near the mid that cross, cancels and modifies of random ids (some long gone)
+static std::vector<IncomingMessage> MakeContinuation(Price midTick) {
+    std::mt19937 rng(26);
+    std::vector<IncomingMessage> flow(CONTINUATION);
+
+    for (int i = 0; i < CONTINUATION; ++i) {
+        IncomingMessage& msg = flow[i];
+        msg = {};
+        uint32_t kind = rng() % 10;
+        if (kind < 6) {
+            msg.orderId = NEW_ORDERS + i;
+            msg.type = 'N';
+            msg.side = (rng() & 1) ? 'B' : 'S';
+            msg.price = midTick - 20 + (Price)(rng() % 41);
+            msg.qty = 1 + rng() % 300;
+            msg.clientId = (int)(rng() % 500);
+        } else {
+            msg.orderId = (int)(rng() % (NEW_ORDERS + i));
+            msg.type = kind < 9 ? 'C' : 'M';
+            msg.price = midTick - 2000 + (Price)(rng() % 4001);
+            msg.qty = (int)(rng() % 100);
+        }
+    }
+    return flow;
+}
+
+static void Apply(OrderBook* book, const std::vector<IncomingMessage>& flow) {
+    for (size_t i = 0; i < flow.size(); ++i) book->ProcessMessage(flow[i]);
+}
+
+static bool DropFromPageCache(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    bool ok = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(fd);
+    return ok;
+}
+
+static double Median(std::vector<double> times) {
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+// cold: the image is dropped from the page cache first (it is clean after Checkpoint)
+static double TimeRestore(const char* path, bool prefault, bool cold, const BookState& expected, int maxId, bool& identical) {
+    std::vector<double> times;
+    for (int r = 0; r < REPS; ++r) {
+        if (cold && !DropFromPageCache(path)) std::cout << "  (could not drop " << path << " from the page cache)" << std::endl;
+
+        Timer timer;
+        timer.Start();
+        OrderBook* book = OrderBook::OpenImage(path, prefault);
+        double ms = timer.Stop();
+        if (book == nullptr) {
+            identical = false;
+            return -1;
+        }
+        times.push_back(ms);
+
+        if (!(StateOf(book, maxId) == expected)) identical = false;
+        delete book;
+    }
+    return Median(times);
+}
+
+int main(int argc, char** argv) {
+    const char* path = argc > 1 ? argv[1] : "/tmp/orderbook.img";
+
+    const Price midTick = PriceScale(TICK).ToTicks(MID);
+    std::vector<IncomingMessage> flow = MakeFlow(midTick);
+    std::vector<IncomingMessage> continuation = MakeContinuation(midTick);
+
+    std::cout << "Snapshot benchmark: " << flow.size() << " messages build the book, image " << path
+              << ", median of " << REPS << std::endl;
+
+    //replay, the way a restart without an image gets its book back
+    std::vector<double> replay;
+    OrderBook* reference = nullptr;
+    for (int r = 0; r < REPS; ++r) {
+        delete reference;
+        reference = new OrderBook(MID, TICK, LEVELS, MAX_ORDERS);
+        Timer timer;
+        timer.Start();
+        Apply(reference, flow);
+        replay.push_back(timer.Stop());
+    }
+    BookState expected = StateOf(reference, NEW_ORDERS);
+    std::cout << "  Book: " << expected.orders << " orders on " << expected.levels << " levels" << std::endl;
+    std::cout << "  Replay into a heap book: " << Median(replay) << " ms" << std::endl;
+
+    //the same flow into a persistent book, then one checkpoint
+    OrderBook* persistent = new OrderBook(MID, TICK, LEVELS, MAX_ORDERS, path);
+    if (!persistent->IsPersistent()) {
+        delete persistent;
+        delete reference;
+        return 1;
+    }
+    Timer timer;
+    timer.Start();
+    Apply(persistent, flow);
+    std::cout << "  Replay into a file backed book: " << timer.Stop() << " ms" << std::endl;
+
+    timer.Start();
+    bool synced = persistent->Checkpoint();
+    std::cout << "  Checkpoint (msync): " << timer.Stop() << " ms" << (synced ? "" : " FAILED") << std::endl;
+    delete persistent;
+    if (!synced) {
+        delete reference;
+        return 1;
+    }
+
+    bool identical = true;
+    std::cout << "  Restore, warm, map only: " << TimeRestore(path, false, false, expected, NEW_ORDERS, identical) << " ms" << std::endl;
+    std::cout << "  Restore, warm, prefaulted: " << TimeRestore(path, true, false, expected, NEW_ORDERS, identical) << " ms" << std::endl;
+    std::cout << "  Restore, cold, map only: " << TimeRestore(path, false, true, expected, NEW_ORDERS, identical) << " ms" << std::endl;
+    std::cout << "  Restore, cold, prefaulted: " << TimeRestore(path, true, true, expected, NEW_ORDERS, identical) << " ms" << std::endl;
+
+    //keep trading on a restored book, it has to go exactly where the replayed one goes
+    DropFromPageCache(path);
+    OrderBook* restored = OrderBook::OpenImage(path, false);
+    if (restored == nullptr) {
+        delete reference;
+        return 1;
+    }
+    std::vector<double> first(2);
+    OrderBook* books[2] = { reference, restored };
+    for (int b = 0; b < 2; ++b) {
+        timer.Start();
+        Apply(books[b], continuation);
+        first[b] = timer.Stop();
+    }
+    std::cout << "  Continuation, " << CONTINUATION << " messages: " << first[0] << " ms on the replayed book, "
+              << first[1] << " ms on the restored one (cold pages, first touch)" << std::endl;
+    if (!(StateOf(restored, NEW_ORDERS + CONTINUATION) == StateOf(reference, NEW_ORDERS + CONTINUATION))) identical = false;
+    delete restored;
+
+    //changed after its checkpoint: must be refused
+    OrderBook* dirty = OrderBook::OpenImage(path);
+    if (dirty != nullptr) {
+        std::cout << "[ERROR] an image that changed after its checkpoint was opened" << std::endl;
+        identical = false;
+        delete dirty;
+    }
+
+    delete reference;
+    std::remove(path);
+
+    if (!identical) {
+        std::cout << "[ERROR] a restored book differs from the replayed one" << std::endl;
+        return 1;
+    }
+    std::cout << "Every restored book matched the replayed one, the dirty image was refused" << std::endl;
+    return 0;
+}
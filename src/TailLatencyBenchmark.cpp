@@ -0,0 +1,174 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <cstdlib>
+
+#include "../Includes/LinearAllocator.h"
+#include "../Includes/StackAllocator.h"
+#include "../Includes/PoolAllocator.h"
+#include "../Includes/FreeListAllocator.h"
+#include "../Includes/TLSFAllocator.h"
+#include "BenchmarkUtils.h"
+
+// Worst case per call: p50, p99, p99.99 and max of every Allocate/Deallocate.
+// Variable size allocators get the same seeded churn (fill, then free a random block and
+// allocate a new random size). The restricted ones run the closest pattern they allow:
+// Pool serves every size from MAX_SIZE chunks, Stack churns in LIFO order and Linear
+// only allocates, resetting when a frame is full.
+
+const int LIVE_BLOCKS = 20000;
+const int CHURN_OPS = 200000;
+const size_t MIN_SIZE = 16;
+const size_t MAX_SIZE = 512;
+const size_t TOTAL_SIZE = 256 * 1024 * 1024;
+
+static void PrintRow(const char* label, LatencyRecorder& alloc, LatencyRecorder& dealloc) {
+    std::cout << std::left << std::setw(16) << label << std::right
+              << " alloc p50 " << std::setw(6) << alloc.Percentile(50)
+              << " p99 " << std::setw(7) << alloc.Percentile(99)
+              << " p99.99 " << std::setw(8) << alloc.Percentile(99.99)
+              << " max " << std::setw(9) << alloc.Max();
+    if (dealloc.Count() > 0) {
+        std::cout << " | free p50 " << std::setw(6) << dealloc.Percentile(50)
+                  << " p99 " << std::setw(7) << dealloc.Percentile(99)
+                  << " p99.99 " << std::setw(8) << dealloc.Percentile(99.99)
+                  << " max " << std::setw(9) << dealloc.Max();
+    }
+    std::cout << std::endl;
+}
+
+// Random churn through any allocate(size)/deallocate(ptr) pair
+template <typename AllocFn, typename FreeFn>
+void Churn(const char* label, AllocFn allocate, FreeFn deallocate) {
+    std::mt19937 rng(2024);
+    std::vector<void*> live(LIVE_BLOCKS);
+    LatencyRecorder allocLatency(LIVE_BLOCKS + CHURN_OPS);
+    LatencyRecorder freeLatency(LIVE_BLOCKS + CHURN_OPS);
+
+    for (int i = 0; i < LIVE_BLOCKS; ++i) {
+        size_t size = MIN_SIZE + rng() % (MAX_SIZE - MIN_SIZE + 1);
+        uint64_t t0 = NowNanos();
+        live[i] = allocate(size);
+        allocLatency.Record(NowNanos() - t0);
+    }
+
+    for (int i = 0; i < CHURN_OPS; ++i) {
+        int victim = (int)(rng() % LIVE_BLOCKS);
+        size_t size = MIN_SIZE + rng() % (MAX_SIZE - MIN_SIZE + 1);
+
+        uint64_t t0 = NowNanos();
+        deallocate(live[victim]);
+        uint64_t t1 = NowNanos();
+        live[victim] = allocate(size);
+        uint64_t t2 = NowNanos();
+
+        freeLatency.Record(t1 - t0);
+        allocLatency.Record(t2 - t1);
+    }
+
+    for (int i = 0; i < LIVE_BLOCKS; ++i) {
+        uint64_t t0 = NowNanos();
+        deallocate(live[i]);
+        freeLatency.Record(NowNanos() - t0);
+    }
+
+    PrintRow(label, allocLatency, freeLatency);
+}
+
+int main() {
+    std::cout << "Tail latency benchmark (ns per call)" << std::endl;
+    std::cout << "Live blocks: " << LIVE_BLOCKS << ", Churn ops: " << CHURN_OPS
+              << ", Sizes: " << MIN_SIZE << ".." << MAX_SIZE << " bytes" << std::endl;
+
+    Churn("malloc/free",
+          [](size_t size) { return malloc(size); },
+          [](void* p) { free(p); });
+
+    {
+        PoolAllocator* pool = new PoolAllocator(TOTAL_SIZE, MAX_SIZE);
+        pool->Init();
+        Churn("Pool (512B)",
+              [pool](size_t size) { return pool->Allocate(size); },
+              [pool](void* p) { pool->Deallocate(p); });
+        delete pool;
+    }
+
+    {
+        FreeListAllocator* freeList = new FreeListAllocator(TOTAL_SIZE, FreeListAllocator::FIRST_FIT);
+        freeList->Init();
+        Churn("FreeList first",
+              [freeList](size_t size) { return freeList->Allocate(size); },
+              [freeList](void* p) { freeList->Deallocate(p); });
+        delete freeList;
+    }
+
+    {
+        FreeListAllocator* freeList = new FreeListAllocator(TOTAL_SIZE, FreeListAllocator::SEGREGATED_FIT);
+        freeList->Init();
+        Churn("FreeList seg",
+              [freeList](size_t size) { return freeList->Allocate(size); },
+              [freeList](void* p) { freeList->Deallocate(p); });
+        delete freeList;
+    }
+
+    {
+        TLSFAllocator* tlsf = new TLSFAllocator(TOTAL_SIZE);
+        tlsf->Init();
+        Churn("TLSF",
+              [tlsf](size_t size) { return tlsf->Allocate(size); },
+              [tlsf](void* p) { tlsf->Deallocate(p); });
+        delete tlsf;
+    }
+
+    {
+        //LIFO churn: random push/pop sequence
+        StackAllocator* stack = new StackAllocator(TOTAL_SIZE);
+        stack->Init();
+
+        std::mt19937 rng(2024);
+        std::vector<void*> live;
+        live.reserve(LIVE_BLOCKS + CHURN_OPS);
+        LatencyRecorder allocLatency(LIVE_BLOCKS + CHURN_OPS);
+        LatencyRecorder freeLatency(LIVE_BLOCKS + CHURN_OPS);
+
+        for (int i = 0; i < LIVE_BLOCKS + CHURN_OPS; ++i) {
+            if (live.empty() || rng() % 2 == 0) {
+                size_t size = MIN_SIZE + rng() % (MAX_SIZE - MIN_SIZE + 1);
+                uint64_t t0 = NowNanos();
+                live.push_back(stack->Allocate(size));
+                allocLatency.Record(NowNanos() - t0);
+            } else {
+                uint64_t t0 = NowNanos();
+                stack->Deallocate(live.back());
+                freeLatency.Record(NowNanos() - t0);
+                live.pop_back();
+            }
+        }
+        PrintRow("Stack (LIFO)", allocLatency, freeLatency);
+        delete stack;
+    }
+
+    {
+        //allocate only, Reset() when the frame is used up
+        LinearAllocator* linear = new LinearAllocator(1024 * 1024);
+        linear->Init();
+
+        std::mt19937 rng(2024);
+        LatencyRecorder allocLatency(LIVE_BLOCKS + CHURN_OPS);
+        LatencyRecorder none(0);
+
+        for (int i = 0; i < LIVE_BLOCKS + CHURN_OPS; ++i) {
+            size_t size = MIN_SIZE + rng() % (MAX_SIZE - MIN_SIZE + 1);
+            if (linear->GetUsedMemory() + size + 8 > 1024 * 1024) linear->Reset();
+
+            uint64_t t0 = NowNanos();
+            linear->Allocate(size);
+            allocLatency.Record(NowNanos() - t0);
+        }
+        PrintRow("Linear", allocLatency, none);
+        delete linear;
+    }
+
+    return 0;
+}
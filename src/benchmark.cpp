@@ -1,11 +1,18 @@
 #include <iostream>
 #include <chrono>
 #include <vector>
+#include <random>
 
 #include "../Includes/LinearAllocator.h"
 #include "../Includes/StackAllocator.h"
 #include "../Includes/PoolAllocator.h"
+#include "../Includes/TypedPool.h"
 #include "../Includes/FreeListAllocator.h" 
+#include "../Includes/TLSFAllocator.h"
+#include "../Includes/BuddyAllocator.h"
+#include "../Includes/OrderBook.h"
+#include "../Includes/LatencyHistogram.h"
+#include "PerfCounters.h"
 
 struct Vector4 {
     float x, y, z, w;
@@ -14,6 +21,22 @@ struct Vector4 {
 const int NUM_OPERATIONS = 500000; 
 const size_t TOTAL_SIZE = 512 * 1024 * 1024; // 512 MB
 
+// mixed size workload: snapshot / message batch sized buffers, 64 B .. 64 KB
+const int MIXED_LIVE = 2000;
+const int MIXED_OPS = 200000;
+
+//log-uniform between 64 B and 64 KB, so small and big buffers are equally common
+static size_t MixedSize(std::mt19937& rng) {
+    int shift = 6 + (int)(rng() % 11);
+    size_t base = (size_t)1 << shift;
+    return base + rng() % base;
+}
+
+// Fill MIXED_LIVE buffers then keep replacing a random one with a new random size.
+// Prints time and how much memory the allocator holds for what was actually requested.
+// The last MIXED_LIVE buffers are left allocated.
+static void RunMixed(const char* label, Allocator* allocator);
+
 class Timer {
     std::chrono::high_resolution_clock::time_point start;
 public:
@@ -31,12 +54,14 @@ int main() {
     std::cout << "Object Size: " << sizeof(Vector4) << " bytes" << std::endl;
 
     Timer timer;
+    PerfCounters counters; //n/a columns when perf_event_open is not allowed
 
     {
         std::vector<Vector4*> ptrs(NUM_OPERATIONS);
 
         std::cout << "Testing Standard new/delete..." << std::endl;
         timer.Start();
+        counters.Start();
 
         for (int i = 0; i < NUM_OPERATIONS; ++i) {
             ptrs[i] = new Vector4();
@@ -46,7 +71,10 @@ int main() {
             delete ptrs[i];
         }
 
-        std::cout << "Result: " << timer.Stop() << " ms" << std::endl;
+        double ms = timer.Stop();
+        counters.Stop();
+        std::cout << "Result: " << ms << " ms" << std::endl;
+        counters.Print("  Counters", 2.0 * NUM_OPERATIONS);
     }
 
     {
@@ -55,13 +83,17 @@ int main() {
         linear->Init();
         
         timer.Start();
+        counters.Start();
         
         for (int i = 0; i < NUM_OPERATIONS; ++i) {
              linear->Allocate(sizeof(Vector4), alignof(Vector4));
         }
         linear->Reset();
 
-        std::cout << "Result: " << timer.Stop() << " ms" << std::endl;
+        double ms = timer.Stop();
+        counters.Stop();
+        std::cout << "Result: " << ms << " ms" << std::endl;
+        counters.Print("  Counters", NUM_OPERATIONS);
         delete linear;
     }
 
@@ -73,6 +105,7 @@ int main() {
         std::vector<void*> ptrs(NUM_OPERATIONS);
 
         timer.Start();
+        counters.Start();
         
         for (int i = 0; i < NUM_OPERATIONS; ++i) {
             ptrs[i] = stack->Allocate(sizeof(Vector4), alignof(Vector4));
@@ -83,7 +116,10 @@ int main() {
             stack->Deallocate(ptrs[i]);
         }
 
-        std::cout << "Result: " << timer.Stop() << " ms" << std::endl;
+        double ms = timer.Stop();
+        counters.Stop();
+        std::cout << "Result: " << ms << " ms" << std::endl;
+        counters.Print("  Counters", 2.0 * NUM_OPERATIONS);
         delete stack;
     }
 
@@ -95,6 +131,7 @@ int main() {
         std::vector<void*> ptrs(NUM_OPERATIONS);
 
         timer.Start();
+        counters.Start();
 
         for (int i = 0; i < NUM_OPERATIONS; ++i) {
             ptrs[i] = pool->Allocate(sizeof(Vector4));
@@ -104,9 +141,106 @@ int main() {
             pool->Deallocate(ptrs[i]);
         }
 
-        std::cout << "Result: " << timer.Stop() << " ms" << std::endl;
+        double ms = timer.Stop();
+        counters.Stop();
+        std::cout << "Result: " << ms << " ms" << std::endl;
+        counters.Print("  Counters", 2.0 * NUM_OPERATIONS);
+        delete pool;
+    }
+
+    {
+        //Init/Reset used to link every chunk of the region, now they only set a bump pointer
+        std::cout << "Testing Pool Allocator startup (" << TOTAL_SIZE / (1024 * 1024) << " MB)..." << std::endl;
+        PoolAllocator* pool = new PoolAllocator(TOTAL_SIZE, sizeof(Vector4), alignof(Vector4));
+
+        timer.Start();
+        pool->Init();
+        double initMs = timer.Stop();
+
+        timer.Start();
+        pool->Reset();
+        double resetMs = timer.Stop();
+
+        std::cout << "Result: Init " << initMs << " ms, Reset " << resetMs << " ms" << std::endl;
         delete pool;
     }
+
+    {
+        //1 MB slabs, so the same workload has to grow the pool a few times
+        std::cout << "Testing growable Pool Allocator (1 MB slabs)..." << std::endl;
+        PoolAllocator* pool = new PoolAllocator(1024 * 1024, sizeof(Vector4), alignof(Vector4), true);
+        pool->Init();
+
+        std::vector<void*> ptrs(NUM_OPERATIONS);
+
+        timer.Start();
+
+        for (int i = 0; i < NUM_OPERATIONS; ++i) {
+            ptrs[i] = pool->Allocate(sizeof(Vector4));
+        }
+
+        for (int i = 0; i < NUM_OPERATIONS; ++i) {
+            pool->Deallocate(ptrs[i]);
+        }
+
+        std::cout << "Result: " << timer.Stop() << " ms, " << pool->GetNumSlabs() << " slabs" << std::endl;
+        delete pool;
+    }
+
+    {
+        //virtual Allocate/Deallocate through the base class vs TypedPool's inlined Create/Destroy.
+        //one untimed round first so none of them pays the first touch of its pages
+        std::cout << "Testing Pool Allocator through Allocator* vs TypedPool..." << std::endl;
+        std::vector<Vector4*> ptrs(NUM_OPERATIONS);
+
+        Allocator* pool = new PoolAllocator((size_t)NUM_OPERATIONS * sizeof(Vector4), sizeof(Vector4), alignof(Vector4));
+        pool->Init();
+        double virtualMs = 0;
+        for (int round = 0; round < 2; ++round) {
+            timer.Start();
+            for (int i = 0; i < NUM_OPERATIONS; ++i) {
+                ptrs[i] = new (pool->Allocate(sizeof(Vector4), alignof(Vector4))) Vector4();
+            }
+            for (int i = 0; i < NUM_OPERATIONS; ++i) {
+                pool->Deallocate(ptrs[i]);
+            }
+            virtualMs = timer.Stop();
+        }
+        delete pool;
+
+        TypedPool<Vector4>* typed = new TypedPool<Vector4>(NUM_OPERATIONS);
+        double typedMs = 0;
+        for (int round = 0; round < 2; ++round) {
+            timer.Start();
+            for (int i = 0; i < NUM_OPERATIONS; ++i) {
+                ptrs[i] = typed->Create();
+            }
+            for (int i = 0; i < NUM_OPERATIONS; ++i) {
+                typed->Destroy(ptrs[i]);
+            }
+            typedMs = timer.Stop();
+        }
+        delete typed;
+
+        TypedPool<Vector4, NUM_OPERATIONS>* inlinePool = new TypedPool<Vector4, NUM_OPERATIONS>();
+        double inlineMs = 0;
+        for (int round = 0; round < 2; ++round) {
+            timer.Start();
+            for (int i = 0; i < NUM_OPERATIONS; ++i) {
+                ptrs[i] = inlinePool->Create();
+            }
+            for (int i = 0; i < NUM_OPERATIONS; ++i) {
+                inlinePool->Destroy(ptrs[i]);
+            }
+            inlineMs = timer.Stop();
+        }
+        delete inlinePool;
+
+        double perOp = 1e6 / (2.0 * NUM_OPERATIONS); //ms per run -> ns per alloc or free
+        std::cout << "Result: Allocator* " << virtualMs << " ms (" << virtualMs * perOp << " ns/op), "
+                  << "TypedPool " << typedMs << " ms (" << typedMs * perOp << " ns/op), "
+                  << "TypedPool inline " << inlineMs << " ms (" << inlineMs * perOp << " ns/op)" << std::endl;
+    }
     
     {
         std::cout << "Testing Free List Allocator..." << std::endl;
@@ -116,6 +250,7 @@ int main() {
         std::vector<void*> ptrs(NUM_OPERATIONS);
 
         timer.Start();
+        counters.Start();
 
         for (int i = 0; i < NUM_OPERATIONS; ++i) {
             ptrs[i] = freeList->Allocate(sizeof(Vector4), alignof(Vector4));
@@ -125,9 +260,126 @@ int main() {
             freeList->Deallocate(ptrs[i]);
         }
 
-        std::cout << "Result: " << timer.Stop() << " ms" << std::endl;
+        double ms = timer.Stop();
+        counters.Stop();
+        std::cout << "Result: " << ms << " ms" << std::endl;
+        counters.Print("  Counters", 2.0 * NUM_OPERATIONS);
         delete freeList;
     }
 
+    {
+        //per message latency, build with -DHFT_LATENCY_STATS for the histograms.
+        //the total time is printed either way so the instrumentation overhead can be compared
+        std::cout << "Testing OrderBook order flow (" << NUM_OPERATIONS << " orders)..." << std::endl;
+        OrderBook* book = new OrderBook();
+
+        std::mt19937 rng(11);
+        Price mid = 10000; //100.0 in 0.01 ticks
+
+        timer.Start();
+        counters.Start();
+        for (int i = 0; i < NUM_OPERATIONS; ++i) {
+            if (rng() % 16 == 0) mid += (rng() % 2) ? 1 : -1;
+            OrderType type = (rng() % 2) ? BUY : SELL;
+            Price price = mid + ((int)(rng() % 21) - 10);
+            book->ProcessOrder(i, type, price, 1 + (int)(rng() % 100));
+            if (i >= 64 && rng() % 4 == 0) book->CancelOrder(i - 64);
+        }
+        double ms = timer.Stop();
+        counters.Stop();
+        std::cout << "Result: " << ms << " ms" << std::endl;
+        counters.Print("  Counters", NUM_OPERATIONS);
+
+#ifdef HFT_LATENCY_STATS
+        book->GetProcessLatency().Print("  ProcessOrder");
+        book->GetPoolLatency().Print("  Pool Create/Destroy");
+
+        //the same histograms around raw allocator calls
+        PoolAllocator* pool = new PoolAllocator(TOTAL_SIZE, sizeof(Vector4), alignof(Vector4));
+        pool->Init();
+        LatencyHistogram allocLatency;
+        LatencyHistogram freeLatency;
+        std::vector<void*> ptrs(NUM_OPERATIONS);
+
+        for (int i = 0; i < NUM_OPERATIONS; ++i) {
+            HFT_LATENCY_SCOPE(allocLatency);
+            ptrs[i] = pool->Allocate(sizeof(Vector4));
+        }
+        for (int i = 0; i < NUM_OPERATIONS; ++i) {
+            HFT_LATENCY_SCOPE(freeLatency);
+            pool->Deallocate(ptrs[i]);
+        }
+        allocLatency.Print("  Pool Allocate");
+        freeLatency.Print("  Pool Deallocate");
+        delete pool;
+#endif
+        delete book;
+    }
+
+    {
+        std::cout << "Mixed size workload (" << MIXED_LIVE << " live buffers, " << MIXED_OPS << " replacements)" << std::endl;
+
+        FreeListAllocator* firstFit = new FreeListAllocator(TOTAL_SIZE, FreeListAllocator::FIRST_FIT);
+        firstFit->Init();
+        RunMixed("Free List (first fit)", firstFit);
+        delete firstFit;
+
+        FreeListAllocator* segregated = new FreeListAllocator(TOTAL_SIZE, FreeListAllocator::SEGREGATED_FIT);
+        segregated->Init();
+        RunMixed("Free List (segregated)", segregated);
+        delete segregated;
+
+        TLSFAllocator* tlsf = new TLSFAllocator(TOTAL_SIZE);
+        tlsf->Init();
+        RunMixed("TLSF", tlsf);
+        delete tlsf;
+
+        BuddyAllocator* buddy = new BuddyAllocator(TOTAL_SIZE);
+        buddy->Init();
+        RunMixed("Buddy", buddy);
+
+        size_t freeMemory = buddy->GetManagedSize() - buddy->GetUsedMemory();
+        std::cout << "  Buddy with " << MIXED_LIVE << " buffers live: free blocks " << buddy->GetNumFreeBlocks()
+                  << ", largest free block " << buddy->GetLargestFreeBlock() << " bytes"
+                  << ", external fragmentation " << 100.0 * (1.0 - (double)buddy->GetLargestFreeBlock() / freeMemory) << " %" << std::endl;
+        delete buddy;
+    }
+
     return 0;
-}
\ No newline at end of file
+}
+
+static void RunMixed(const char* label, Allocator* allocator) {
+    std::cout << "Testing " << label << "..." << std::endl;
+
+    std::mt19937 rng(7);
+    std::vector<void*> ptrs(MIXED_LIVE);
+    std::vector<size_t> sizes(MIXED_LIVE);
+    size_t requested = 0;
+
+    Timer timer;
+    timer.Start();
+
+    for (int i = 0; i < MIXED_LIVE; ++i) {
+        sizes[i] = MixedSize(rng);
+        ptrs[i] = allocator->Allocate(sizes[i]);
+        requested += sizes[i];
+    }
+
+    for (int i = 0; i < MIXED_OPS; ++i) {
+        int victim = (int)(rng() % MIXED_LIVE);
+        allocator->Deallocate(ptrs[victim]);
+        requested -= sizes[victim];
+
+        sizes[victim] = MixedSize(rng);
+        ptrs[victim] = allocator->Allocate(sizes[victim]);
+        requested += sizes[victim];
+    }
+
+    double ms = timer.Stop();
+
+    //internal fragmentation: bytes held (headers, padding, rounding) per byte requested
+    std::cout << "Result: " << ms << " ms, used " << allocator->GetUsedMemory() << " bytes for " << requested
+              << " requested (" << 100.0 * ((double)allocator->GetUsedMemory() / requested - 1.0) << " % overhead)" << std::endl;
+
+    //buffers stay live so the caller can look at the fragmented heap, deleting the allocator frees them
+}